@@ -0,0 +1,262 @@
+// ==========================================================================
+//                                  lambda
+// ==========================================================================
+// Copyright (c) 2013-2015, Hannes Hauswedell, FU Berlin
+// All rights reserved.
+//
+// This file is part of Lambda.
+//
+// Lambda is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Lambda is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with Lambda.  If not, see <http://www.gnu.org/licenses/>.*/
+// ==========================================================================
+// Author: Hannes Hauswedell <hannes.hauswedell @ fu-berlin.de>
+// ==========================================================================
+// binary_output.hpp: compact binary result format (.m8b)
+// ==========================================================================
+
+#ifndef SEQAN_LAMBDA_BINARY_OUTPUT_H_
+#define SEQAN_LAMBDA_BINARY_OUTPUT_H_
+
+#include <cstring>
+#include <string>
+
+#include <seqan/basic.h>
+#include <seqan/blast.h>
+
+using namespace seqan;
+
+// The .m8b file is meant to be mapped into memory and read in place, all
+// values are stored in the byte order of the machine that wrote the file:
+//
+//   BinaryHeader                                     (64 bytes)
+//   query file name, database file name              (not 0-terminated)
+//   0-padding to a multiple of 8                     (-> header.headerSize)
+//   BinaryMatch [CIGAR]  ...                         (one per match)
+//
+// Matches of one query are stored consecutively and sorted as in the text
+// output. If header.hasCigar is set, every BinaryMatch is followed by
+// cigarLength uint32 operations (len << 4 | op, ops are BAM's M=0, I=1, D=2,
+// query is the read, subject the reference), padded with 0 to an even number
+// so that all matches stay 8-byte aligned.
+
+// ============================================================================
+// Tags, Classes, Enums
+// ============================================================================
+
+// ----------------------------------------------------------------------------
+// struct BinaryHeader
+// ----------------------------------------------------------------------------
+
+struct BinaryHeader
+{
+    static constexpr char     MAGIC[8] = { 'L', 'A', 'M', 'B', 'D', 'A', 'B', '\0' };
+    static constexpr uint32_t VERSION  = 1;
+
+    char        magic[8];
+    uint32_t    version;
+    uint32_t    headerSize;         // offset of the first match
+    uint32_t    matchSize;          // sizeof(BinaryMatch) of the writer
+    uint32_t    qryFileLength;      // length of query file name
+    uint32_t    dbFileLength;       // length of database file name
+    uint8_t     blastProgram;       // BlastProgram
+    uint8_t     hasCigar;
+    uint8_t     reserved[34];
+};
+
+constexpr char     BinaryHeader::MAGIC[8];
+constexpr uint32_t BinaryHeader::VERSION;
+
+static_assert(sizeof(BinaryHeader) == 64, "BinaryHeader must be 64 bytes.");
+
+// ----------------------------------------------------------------------------
+// struct BinaryMatch
+// ----------------------------------------------------------------------------
+
+// coordinates are those of BlastMatch, i.e. on the translated/reverse
+// complemented sequences, together with the frames
+
+struct BinaryMatch
+{
+    double      bitScore;
+    double      eValue;
+    uint64_t    qryIdx;             // number of the query in the query file
+    uint64_t    subjIdx;            // number of the subject in the database
+    uint32_t    qStart;
+    uint32_t    qEnd;
+    uint32_t    sStart;
+    uint32_t    sEnd;
+    uint32_t    qLength;
+    uint32_t    sLength;
+    int32_t     score;
+    uint32_t    alignLength;
+    uint32_t    numMatches;
+    uint32_t    numMismatches;
+    uint32_t    numPositive;
+    uint32_t    numGaps;
+    uint32_t    numGapOpens;
+    float       identity;
+    float       similarity;
+    int8_t      qFrameShift;
+    int8_t      sFrameShift;
+    uint16_t    reserved;
+    uint32_t    cigarLength;        // number of CIGAR operations following
+    uint32_t    reserved2;
+};
+
+static_assert(sizeof(BinaryMatch) == 104, "BinaryMatch must be 104 bytes.");
+
+// ============================================================================
+// Functions
+// ============================================================================
+
+// ----------------------------------------------------------------------------
+// Function writeBinaryHeader()
+// ----------------------------------------------------------------------------
+
+inline void
+writeBinaryHeader(std::string          & buffer,
+                  BlastProgram   const   blastProgram,
+                  bool           const   hasCigar,
+                  std::string    const & qryFile,
+                  std::string    const & dbFile)
+{
+    BinaryHeader h;
+    std::memset(&h, 0, sizeof(h));
+    std::memcpy(h.magic, BinaryHeader::MAGIC, sizeof(h.magic));
+    h.version       = BinaryHeader::VERSION;
+    h.matchSize     = sizeof(BinaryMatch);
+    h.qryFileLength = qryFile.size();
+    h.dbFileLength  = dbFile.size();
+    h.blastProgram  = static_cast<uint8_t>(blastProgram);
+    h.hasCigar      = hasCigar;
+    h.headerSize    = (sizeof(h) + qryFile.size() + dbFile.size() + 7) / 8 * 8;
+
+    buffer.append(reinterpret_cast<char const *>(&h), sizeof(h));
+    buffer.append(qryFile);
+    buffer.append(dbFile);
+    buffer.append(h.headerSize - sizeof(h) - qryFile.size() - dbFile.size(), '\0');
+}
+
+// ----------------------------------------------------------------------------
+// Function appendBinaryMatch()
+// ----------------------------------------------------------------------------
+
+template <typename TBlastMatch>
+inline void
+appendBinaryMatch(std::string       & buffer,
+                  TBlastMatch const & bm,
+                  uint64_t    const   qryIdx,
+                  uint64_t    const   subjIdx,
+                  bool        const   withCigar)
+{
+    BinaryMatch m;
+    m.bitScore      = bm.bitScore;
+    m.eValue        = bm.eValue;
+    m.qryIdx        = qryIdx;
+    m.subjIdx       = subjIdx;
+    m.qStart        = bm.qStart;
+    m.qEnd          = bm.qEnd;
+    m.sStart        = bm.sStart;
+    m.sEnd          = bm.sEnd;
+    m.qLength       = bm.qLength;
+    m.sLength       = bm.sLength;
+    m.score         = bm.alignStats.alignmentScore;
+    m.alignLength   = bm.alignStats.alignmentLength;
+    m.numMatches    = bm.alignStats.numMatches;
+    m.numMismatches = bm.alignStats.numMismatches;
+    m.numPositive   = bm.alignStats.numPositiveScores;
+    m.numGaps       = bm.alignStats.numGaps;
+    m.numGapOpens   = bm.alignStats.numGapOpens;
+    m.identity      = bm.alignStats.alignmentIdentity;
+    m.similarity    = bm.alignStats.alignmentSimilarity;
+    m.qFrameShift   = bm.qFrameShift;
+    m.sFrameShift   = bm.sFrameShift;
+    m.reserved      = 0;
+    m.cigarLength   = 0;
+    m.reserved2     = 0;
+
+    if (!withCigar)
+    {
+        buffer.append(reinterpret_cast<char const *>(&m), sizeof(m));
+        return;
+    }
+
+    // reserve the record, fill in the number of operations afterwards
+    size_t const recPos = buffer.size();
+    buffer.append(sizeof(m), '\0');
+
+    uint32_t op = 0;
+    uint32_t len = 0;
+    uint32_t n = 0;
+    auto appendOp = [&] ()
+    {
+        uint32_t const c = (len << 4) | op;
+        buffer.append(reinterpret_cast<char const *>(&c), sizeof(c));
+        ++n;
+    };
+
+    auto it0 = begin(bm.alignRow0);
+    auto it1 = begin(bm.alignRow1);
+    for (; it0 != end(bm.alignRow0); ++it0, ++it1)
+    {
+        uint32_t const o = isGap(it0) ? 2 : (isGap(it1) ? 1 : 0);
+        if ((len > 0) && (o != op))
+        {
+            appendOp();
+            len = 0;
+        }
+        op = o;
+        ++len;
+    }
+    if (len > 0)
+        appendOp();
+
+    if (n % 2) // keep 8-byte alignment
+        buffer.append(sizeof(uint32_t), '\0');
+
+    m.cigarLength = n;
+    std::memcpy(&buffer[recPos], &m, sizeof(m));
+}
+
+// ----------------------------------------------------------------------------
+// Function readBinaryHeader()
+// ----------------------------------------------------------------------------
+
+// checks the header of a mapped .m8b file, returns non-zero if it is invalid
+
+template <typename TString>
+inline int
+readBinaryHeader(BinaryHeader       & h,
+                 std::string        & qryFile,
+                 std::string        & dbFile,
+                 TString      const & file)
+{
+    if (length(file) < sizeof(BinaryHeader))
+        return 1;
+
+    char const * data = &file[0];
+    std::memcpy(&h, data, sizeof(h));
+
+    if ((std::memcmp(h.magic, BinaryHeader::MAGIC, sizeof(h.magic)) != 0) ||
+        (h.version != BinaryHeader::VERSION) ||
+        (h.matchSize != sizeof(BinaryMatch)) ||
+        (h.headerSize > length(file)) ||
+        (sizeof(h) + (uint64_t)h.qryFileLength + h.dbFileLength > h.headerSize))
+        return 1;
+
+    qryFile.assign(data + sizeof(h), h.qryFileLength);
+    dbFile.assign(data + sizeof(h) + h.qryFileLength, h.dbFileLength);
+    return 0;
+}
+
+#endif // SEQAN_LAMBDA_BINARY_OUTPUT_H_
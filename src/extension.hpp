@@ -0,0 +1,597 @@
+// ==========================================================================
+//                                  lambda
+// ==========================================================================
+// Copyright (c) 2013-2015, Hannes Hauswedell, FU Berlin
+// All rights reserved.
+//
+// This file is part of Lambda.
+//
+// Lambda is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Lambda is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with Lambda.  If not, see <http://www.gnu.org/licenses/>.*/
+// ==========================================================================
+// Author: Hannes Hauswedell <hannes.hauswedell @ fu-berlin.de>
+// ==========================================================================
+// extension.hpp: score-only gapped extension
+// ==========================================================================
+
+#ifndef SEQAN_LAMBDA_EXTENSION_H_
+#define SEQAN_LAMBDA_EXTENSION_H_
+
+#include <algorithm>
+#include <climits>
+#include <vector>
+
+#include <seqan/basic.h>
+
+#include "ungapped.hpp"
+
+// With GCC on x86 the SIMD kernels are compiled for SSE4.1 and AVX2 and the
+// instruction set is chosen at runtime, otherwise only the instruction sets
+// enabled at compile time are used.
+#if defined(__GNUC__) && !defined(__clang__) && (defined(__x86_64__) || defined(__i386__))
+#define LAMBDA_EXTENSION_DISPATCH 1
+#endif
+#if defined(LAMBDA_EXTENSION_DISPATCH) || defined(__SSE4_1__)
+#define LAMBDA_EXTENSION_SSE4 1
+#include <smmintrin.h>
+#endif
+#if defined(LAMBDA_EXTENSION_DISPATCH) || defined(__AVX2__)
+#define LAMBDA_EXTENSION_AVX2 1
+#include <immintrin.h>
+#endif
+
+using namespace seqan;
+
+// The functions here compute the score that seqan's _extendAlignmentImpl()
+// would return for one direction, but without the trace matrix. The DP is the
+// one of AlignExtend_: the alignment starts in the top left cell and may end
+// anywhere, the horizontal sequence is column-wise, bands are given as
+// diagonals (column - row) and the x-drop criterion is checked at the end of
+// every column against the maximum of that column. The horizontal sequence
+// is given as score rows, from the UngappedScoreTable or a QueryProfile.
+//
+// extensionScore() does a single extension; with SIMD it computes strips of
+// columns along their anti-diagonals. Banded extensions can also be collected
+// in an ExtensionBatch and are then computed by scoreExtensions() side by side
+// in the int32 lanes of a SIMD register, one extension per lane. All of them
+// give the same results as _extensionScoreScalar().
+
+// ============================================================================
+// Tags, Classes, Enums
+// ============================================================================
+
+// ----------------------------------------------------------------------------
+// enum ExtensionIsa
+// ----------------------------------------------------------------------------
+
+enum class ExtensionIsa : uint8_t
+{
+    SCALAR,
+    SSE4,
+    AVX2
+};
+
+// ----------------------------------------------------------------------------
+// struct ExtensionParams
+// ----------------------------------------------------------------------------
+
+struct ExtensionParams
+{
+    int     gapOpen;        // seqan's scoreGapOpen(), i.e. including the first extension
+    int     gapExtend;
+    bool    banded;
+    int     lowerDiag;
+    int     upperDiag;
+    bool    xDrop;
+    int     xDropOff;
+};
+
+// ----------------------------------------------------------------------------
+// struct ExtensionScratch
+// ----------------------------------------------------------------------------
+
+// reused between calls to save allocations
+struct ExtensionScratch
+{
+    std::vector<int>    h;
+    std::vector<int>    e;
+    std::vector<int>    hOrds;
+    std::vector<int>    vRev;
+};
+
+// ----------------------------------------------------------------------------
+// struct ExtensionBatch
+// ----------------------------------------------------------------------------
+
+// banded extensions that share the parameters, see appendExtension()
+struct ExtensionBatch
+{
+    struct Problem
+    {
+        unsigned    hBegin;     // in hRows
+        unsigned    hLen;
+        unsigned    hStored;    // the band ends before the rest of the sequence
+        unsigned    vBegin;
+        unsigned    vLen;
+        unsigned    vStored;
+        int         score;      // set by scoreExtensions()
+    };
+
+    ExtensionParams             params;
+    int const *                 scores;     // the rows of all problems are in here
+    std::vector<int>            hRows;      // offsets of the rows in scores
+    std::vector<unsigned char>  ords;       // of the vertical sequences
+    std::vector<Problem>        problems;
+
+    // buffers of the kernels, lane-interleaved
+    std::vector<int>            hOrds;
+    std::vector<int>            vOrds;
+    std::vector<int>            cells;
+    ExtensionScratch            scratch;
+};
+
+// ----------------------------------------------------------------------------
+// SIMD kernels
+// ----------------------------------------------------------------------------
+
+// int32 vectors; masks are vectors with all bits of the selected lanes set
+
+#if defined(LAMBDA_EXTENSION_SSE4)
+#if defined(LAMBDA_EXTENSION_DISPATCH)
+#pragma GCC push_options
+#pragma GCC target("sse4.1")
+#endif
+
+struct ExtensionSimdSse4
+{
+    typedef __m128i TVec;
+    static constexpr unsigned LANES = 4;
+
+    static TVec set1(int const x)                   { return _mm_set1_epi32(x); }
+    static TVec laneIndex()                         { return _mm_setr_epi32(0, 1, 2, 3); }
+    static TVec load(int const * p)                 { return _mm_loadu_si128(reinterpret_cast<__m128i const *>(p)); }
+    static void store(int * p, TVec const v)        { _mm_storeu_si128(reinterpret_cast<__m128i *>(p), v); }
+    static TVec add(TVec const a, TVec const b)     { return _mm_add_epi32(a, b); }
+    static TVec sub(TVec const a, TVec const b)     { return _mm_sub_epi32(a, b); }
+    static TVec max(TVec const a, TVec const b)     { return _mm_max_epi32(a, b); }
+    static TVec min(TVec const a, TVec const b)     { return _mm_min_epi32(a, b); }
+    static TVec gt(TVec const a, TVec const b)      { return _mm_cmpgt_epi32(a, b); }
+    static TVec eq(TVec const a, TVec const b)      { return _mm_cmpeq_epi32(a, b); }
+    static TVec and_(TVec const a, TVec const b)    { return _mm_and_si128(a, b); }
+    static TVec or_(TVec const a, TVec const b)     { return _mm_or_si128(a, b); }
+    static TVec andNot(TVec const m, TVec const b)  { return _mm_andnot_si128(m, b); }
+    static TVec blend(TVec const a, TVec const b, TVec const m) { return _mm_blendv_epi8(a, b, m); }
+    static bool any(TVec const m)                   { return !_mm_testz_si128(m, m); }
+    // lane k of the result is lane k - 1 of v, lane 0 is x
+    static TVec shiftIn(TVec const v, int const x)  { return _mm_insert_epi32(_mm_slli_si128(v, 4), x, 0); }
+    static TVec gather(int const * base, TVec const idx)
+    {
+        return _mm_set_epi32(base[_mm_extract_epi32(idx, 3)], base[_mm_extract_epi32(idx, 2)],
+                             base[_mm_extract_epi32(idx, 1)], base[_mm_cvtsi128_si32(idx)]);
+    }
+};
+
+namespace extension_sse4
+{
+typedef ExtensionSimdSse4 TSimd;
+#include "extension_kernels.hpp"
+}
+
+#if defined(LAMBDA_EXTENSION_DISPATCH)
+#pragma GCC pop_options
+#endif
+#endif // LAMBDA_EXTENSION_SSE4
+
+#if defined(LAMBDA_EXTENSION_AVX2)
+#if defined(LAMBDA_EXTENSION_DISPATCH)
+#pragma GCC push_options
+#pragma GCC target("avx2")
+#endif
+
+struct ExtensionSimdAvx2
+{
+    typedef __m256i TVec;
+    static constexpr unsigned LANES = 8;
+
+    static TVec set1(int const x)                   { return _mm256_set1_epi32(x); }
+    static TVec laneIndex()                         { return _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7); }
+    static TVec load(int const * p)                 { return _mm256_loadu_si256(reinterpret_cast<__m256i const *>(p)); }
+    static void store(int * p, TVec const v)        { _mm256_storeu_si256(reinterpret_cast<__m256i *>(p), v); }
+    static TVec add(TVec const a, TVec const b)     { return _mm256_add_epi32(a, b); }
+    static TVec sub(TVec const a, TVec const b)     { return _mm256_sub_epi32(a, b); }
+    static TVec max(TVec const a, TVec const b)     { return _mm256_max_epi32(a, b); }
+    static TVec min(TVec const a, TVec const b)     { return _mm256_min_epi32(a, b); }
+    static TVec gt(TVec const a, TVec const b)      { return _mm256_cmpgt_epi32(a, b); }
+    static TVec eq(TVec const a, TVec const b)      { return _mm256_cmpeq_epi32(a, b); }
+    static TVec and_(TVec const a, TVec const b)    { return _mm256_and_si256(a, b); }
+    static TVec or_(TVec const a, TVec const b)     { return _mm256_or_si256(a, b); }
+    static TVec andNot(TVec const m, TVec const b)  { return _mm256_andnot_si256(m, b); }
+    static TVec blend(TVec const a, TVec const b, TVec const m) { return _mm256_blendv_epi8(a, b, m); }
+    static bool any(TVec const m)                   { return !_mm256_testz_si256(m, m); }
+    // lane k of the result is lane k - 1 of v, lane 0 is x
+    static TVec shiftIn(TVec const v, int const x)
+    {
+        TVec const up = _mm256_permutevar8x32_epi32(v, _mm256_setr_epi32(0, 0, 1, 2, 3, 4, 5, 6));
+        return _mm256_blend_epi32(up, _mm256_set1_epi32(x), 1);
+    }
+    static TVec gather(int const * base, TVec const idx) { return _mm256_i32gather_epi32(base, idx, 4); }
+};
+
+namespace extension_avx2
+{
+typedef ExtensionSimdAvx2 TSimd;
+#include "extension_kernels.hpp"
+}
+
+#if defined(LAMBDA_EXTENSION_DISPATCH)
+#pragma GCC pop_options
+#endif
+#endif // LAMBDA_EXTENSION_AVX2
+
+// ============================================================================
+// Functions
+// ============================================================================
+
+// ----------------------------------------------------------------------------
+// Function extensionIsa()
+// ----------------------------------------------------------------------------
+
+inline ExtensionIsa
+extensionIsa()
+{
+#if defined(LAMBDA_EXTENSION_DISPATCH)
+    static ExtensionIsa const isa = __builtin_cpu_supports("avx2")   ? ExtensionIsa::AVX2
+                                  : __builtin_cpu_supports("sse4.1") ? ExtensionIsa::SSE4
+                                  : ExtensionIsa::SCALAR;
+    return isa;
+#elif defined(LAMBDA_EXTENSION_AVX2)
+    return ExtensionIsa::AVX2;
+#elif defined(LAMBDA_EXTENSION_SSE4)
+    return ExtensionIsa::SSE4;
+#else
+    return ExtensionIsa::SCALAR;
+#endif
+}
+
+// ----------------------------------------------------------------------------
+// Function extensionLanes()
+// ----------------------------------------------------------------------------
+
+// number of extensions scoreExtensions() computes at once
+inline unsigned
+extensionLanes()
+{
+    switch (extensionIsa())
+    {
+        case ExtensionIsa::AVX2: return 8;
+        case ExtensionIsa::SSE4: return 4;
+        default:                 return 1;
+    }
+}
+
+// ----------------------------------------------------------------------------
+// Function _extensionScoreScalar()
+// ----------------------------------------------------------------------------
+
+template <typename TRows, typename TVIt>
+inline int
+_extensionScoreScalar(TRows            const & rows,
+                      unsigned         const   hLen,
+                      TVIt                     vIt,
+                      unsigned         const   vLen,
+                      ExtensionParams  const & params,
+                      ExtensionScratch       & scratch)
+{
+    int const NEG = INT_MIN / 4;
+
+    // rows of column j are [rowBegin(j), rowEnd(j))
+    auto rowBegin = [&] (long const j) -> long
+    {
+        return params.banded ? std::max(0l, j - params.upperDiag) : 0l;
+    };
+    auto rowEnd = [&] (long const j) -> long
+    {
+        return params.banded ? std::min((long)vLen, j - params.lowerDiag) + 1 : (long)vLen + 1;
+    };
+
+    // rows behind the band of the last column are never reached
+    unsigned const reached = params.banded ? std::min((long)vLen, (long)hLen - params.lowerDiag) : vLen;
+    scratch.h.assign(reached + 1, NEG);
+    scratch.e.assign(reached + 1, NEG);
+    int * H = &scratch.h[0];
+    int * E = &scratch.e[0];
+
+    // seqan's banded DP only does single cell for one column
+    if (params.banded && (hLen == 1))
+        return 0;
+
+    // The banded DP of seqan additionally checks the x-drop criterion against
+    // the last cell of one column, where the band starts spanning the full
+    // column or stops touching the top of the matrix; if it terminates there,
+    // one more column is computed.
+    long extraCheck = -1;
+    if (params.banded && params.xDrop)
+    {
+        long const V = vLen;
+        long const up = params.upperDiag;
+        long const lo = params.lowerDiag;
+        long top = std::min((long)hLen - 1, std::max(0l, up));
+        long mid = std::min((long)hLen - 1, std::max(0l, V + lo));
+        if (up > V + lo)
+            extraCheck = std::min(top, mid);
+        else if (lo + V < (long)hLen)
+            extraCheck = mid;
+    }
+
+    int best = 0;
+    int colMax = NEG;
+    int lastCell = 0;
+    bool terminated = false;
+
+    // initial column: vertical gaps only
+    {
+        long const b = rowBegin(0);
+        long const e = rowEnd(0);
+        if (b > 0 || e <= 0) // band does not contain the origin
+            return 0;
+        H[0] = 0;
+        colMax = 0;
+        for (long i = 1; i < e; ++i)
+        {
+            H[i] = params.gapOpen + (i - 1) * params.gapExtend;
+            colMax = std::max(colMax, H[i]);
+        }
+        lastCell = H[e - 1];
+        // (only the banded DP checks the initial column)
+        if (params.xDrop && params.banded && (best - colMax >= params.xDropOff))
+            return best;
+        colMax = NEG;
+        if (extraCheck == 0)
+        {
+            if (best - lastCell >= params.xDropOff)
+                terminated = true;
+            else
+                colMax = NEG;
+        }
+    }
+
+    for (long j = 1; j <= (long)hLen; ++j)
+    {
+        long const b = rowBegin(j);
+        long const e = rowEnd(j);
+        long const pb = rowBegin(j - 1);
+        long const pe = rowEnd(j - 1);
+        if (b >= e)
+            break;
+
+        int const * hRow = rows(j - 1);
+
+        int diag = (b > 0 && b - 1 >= pb && b - 1 < pe) ? H[b - 1] : NEG; // H[i-1][j-1]
+        int f = NEG;
+        int hAbove = NEG;
+        for (long i = b; i < e; ++i)
+        {
+            bool const inPrev = (i >= pb) && (i < pe);
+            int const hLeft = inPrev ? H[i] : NEG;
+            int const eLeft = inPrev ? E[i] : NEG;
+
+            int const eCur = std::max(hLeft + params.gapOpen, eLeft + params.gapExtend);
+            int const fCur = (i > b) ? std::max(hAbove + params.gapOpen, f + params.gapExtend) : NEG;
+            int hCur = std::max(eCur, fCur);
+            if (i > 0)
+                hCur = std::max(hCur, diag + hRow[ordValue(*(vIt + (i - 1)))]);
+
+            diag = hLeft;
+            H[i] = hCur;
+            E[i] = eCur;
+            f = fCur;
+            hAbove = hCur;
+            colMax = std::max(colMax, hCur);
+            best = std::max(best, hCur);
+        }
+        lastCell = H[e - 1];
+
+        if (terminated)
+            break;
+        if (!params.xDrop)
+            continue;
+        if (best - colMax >= params.xDropOff)
+            break;
+        colMax = NEG;
+
+        if (j == extraCheck)
+        {
+            if (best - lastCell >= params.xDropOff)
+                terminated = true;  // still compute the next column
+            else
+                colMax = NEG;
+        }
+    }
+
+    return best;
+}
+
+// ----------------------------------------------------------------------------
+// Function _scoreStrips()
+// ----------------------------------------------------------------------------
+
+// lay out the parts of the sequences the band can reach for scoreStrips()
+// and run it
+template <typename TRows, typename TVIt>
+inline int
+_scoreStrips(TRows const & rows, unsigned const hLen, TVIt vIt, unsigned const vLen,
+             ExtensionParams const & params, ExtensionScratch & scratch, ExtensionIsa const isa)
+{
+    unsigned const L = extensionLanes();
+    unsigned const hStored = params.banded ? std::min((long)hLen, (long)vLen + params.upperDiag) : hLen;
+    unsigned const vStored = params.banded ? std::min((long)vLen, (long)hStored - params.lowerDiag) : vLen;
+
+    // offsets of the rows relative to the first one
+    int const * scores = rows(0);
+    scratch.hOrds.assign(hStored + L, 0);
+    for (unsigned j = 0; j < hStored; ++j)
+        scratch.hOrds[j] = rows(j) - scores;
+    scratch.vRev.assign(vStored + 2 * L, 0);
+    for (unsigned i = 0; i < vStored; ++i, ++vIt)
+        scratch.vRev[vStored + L - 1 - i] = ordValue(*vIt);
+
+    switch (isa)
+    {
+#if defined(LAMBDA_EXTENSION_AVX2)
+        case ExtensionIsa::AVX2:
+            return extension_avx2::scoreStrips(scores, &scratch.hOrds[0], hLen, &scratch.vRev[0], vStored, vLen,
+                                               params, scratch);
+#endif
+#if defined(LAMBDA_EXTENSION_SSE4)
+        case ExtensionIsa::SSE4:
+            return extension_sse4::scoreStrips(scores, &scratch.hOrds[0], hLen, &scratch.vRev[0], vStored, vLen,
+                                               params, scratch);
+#endif
+        default:
+            SEQAN_FAIL("No SIMD kernel for this instruction set.");
+            return 0;
+    }
+}
+
+// ----------------------------------------------------------------------------
+// Function extensionScore()
+// ----------------------------------------------------------------------------
+
+// rows are the score rows of the horizontal sequence (see TableRows), vIt is
+// a random access iterator over the vertical one, both in the direction of
+// the extension; hLen and vLen are their lengths
+
+template <typename TRows, typename TVIt>
+inline int
+extensionScore(TRows            const & rows,
+               unsigned         const   hLen,
+               TVIt                     vIt,
+               unsigned         const   vLen,
+               ExtensionParams  const & params,
+               ExtensionScratch       & scratch)
+{
+    ExtensionIsa const isa = extensionIsa();
+    // a strip has to be filled for the SIMD version to pay off
+    if ((isa == ExtensionIsa::SCALAR) || (hLen < 2 * extensionLanes()))
+        return _extensionScoreScalar(rows, hLen, vIt, vLen, params, scratch);
+    return _scoreStrips(rows, hLen, vIt, vLen, params, scratch, isa);
+}
+
+// ----------------------------------------------------------------------------
+// Function clear()
+// ----------------------------------------------------------------------------
+
+// only banded extensions with a band around the start cell are supported; the
+// rows of all extensions have to point into scores
+inline void
+clear(ExtensionBatch & batch, ExtensionParams const & params, int const * scores)
+{
+    SEQAN_ASSERT(params.banded);
+    SEQAN_ASSERT_LT(params.lowerDiag, 0);
+    SEQAN_ASSERT_GT(params.upperDiag, 0);
+
+    batch.params = params;
+    batch.scores = scores;
+    batch.hRows.clear();
+    batch.ords.clear();
+    batch.problems.clear();
+}
+
+// ----------------------------------------------------------------------------
+// Function appendExtension()
+// ----------------------------------------------------------------------------
+
+// copies the parts of the sequences the band can reach and returns the index of
+// the new problem; hLen and vLen must not be 0
+
+template <typename TRows, typename TVIt>
+inline unsigned
+appendExtension(ExtensionBatch & batch, TRows const & rows, unsigned const hLen, TVIt vIt, unsigned const vLen)
+{
+    SEQAN_ASSERT_GT(hLen, 0u);
+    SEQAN_ASSERT_GT(vLen, 0u);
+
+    ExtensionBatch::Problem p;
+    p.hLen = hLen;
+    p.vLen = vLen;
+    // columns behind vLen + upperDiag are never computed, neither are rows
+    // behind the last column - lowerDiag
+    p.hStored = std::min((long)hLen, (long)vLen + batch.params.upperDiag);
+    p.vStored = std::min((long)vLen, (long)p.hStored - batch.params.lowerDiag);
+    p.score = 0;
+
+    p.hBegin = batch.hRows.size();
+    for (unsigned j = 0; j < p.hStored; ++j)
+        batch.hRows.push_back(rows(j) - batch.scores);
+    p.vBegin = batch.ords.size();
+    for (unsigned i = 0; i < p.vStored; ++i, ++vIt)
+        batch.ords.push_back(ordValue(*vIt));
+
+    batch.problems.push_back(p);
+    return batch.problems.size() - 1;
+}
+
+// ----------------------------------------------------------------------------
+// Function scoreExtensions()
+// ----------------------------------------------------------------------------
+
+// Fills the lanes with as many problems as there are. A single problem is
+// better computed in strips, if the band is much wider than the strip.
+
+inline void
+scoreExtensions(ExtensionBatch & batch)
+{
+    ExtensionIsa const isa = extensionIsa();
+    unsigned const L = extensionLanes();
+    unsigned const W = batch.params.upperDiag - batch.params.lowerDiag + 1;
+
+    for (unsigned first = 0; first < batch.problems.size(); first += L)
+    {
+        unsigned const n = std::min<unsigned>(L, batch.problems.size() - first);
+
+        if ((isa == ExtensionIsa::SCALAR) || (n * (W + 2 * L - 2) < L * W))
+        {
+            for (unsigned k = first; k < first + n; ++k)
+            {
+                ExtensionBatch::Problem & p = batch.problems[k];
+                // only the stored parts of the sequences are ever reached
+                int const * hRows = &batch.hRows[p.hBegin];
+                auto const rows = [&batch, hRows] (long const j) { return batch.scores + hRows[j]; };
+                auto const vIt = batch.ords.begin() + p.vBegin;
+                if ((isa == ExtensionIsa::SCALAR) || (p.hLen < 2 * L))
+                    p.score = _extensionScoreScalar(rows, p.hLen, vIt, p.vLen, batch.params, batch.scratch);
+                else
+                    p.score = _scoreStrips(rows, p.hLen, vIt, p.vLen, batch.params, batch.scratch, isa);
+            }
+            continue;
+        }
+
+        switch (isa)
+        {
+#if defined(LAMBDA_EXTENSION_AVX2)
+            case ExtensionIsa::AVX2:
+                extension_avx2::scoreLanes(batch, first, n);
+                break;
+#endif
+#if defined(LAMBDA_EXTENSION_SSE4)
+            case ExtensionIsa::SSE4:
+                extension_sse4::scoreLanes(batch, first, n);
+                break;
+#endif
+            default:
+                break;
+        }
+    }
+}
+
+#endif // SEQAN_LAMBDA_EXTENSION_H_
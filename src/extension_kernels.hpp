@@ -0,0 +1,369 @@
+// ==========================================================================
+//                                  lambda
+// ==========================================================================
+// Copyright (c) 2013-2015, Hannes Hauswedell, FU Berlin
+// All rights reserved.
+//
+// This file is part of Lambda.
+//
+// Lambda is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Lambda is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with Lambda.  If not, see <http://www.gnu.org/licenses/>.*/
+// ==========================================================================
+// Author: Hannes Hauswedell <hannes.hauswedell @ fu-berlin.de>
+// ==========================================================================
+// extension_kernels.hpp: SIMD kernels of extension.hpp
+// ==========================================================================
+
+// No include guard: extension.hpp includes this file once per instruction set,
+// inside a namespace that defines TSimd (see struct ExtensionSimdAvx2).
+
+// ============================================================================
+// Functions
+// ============================================================================
+
+// ----------------------------------------------------------------------------
+// Function scoreLanes()
+// ----------------------------------------------------------------------------
+
+// The band is stored relative to the column: slot t of column j is row
+// j - upperDiag + t, so the cell left of slot t is slot t + 1 and the diagonal
+// predecessor is slot t of the previous column. Lanes run in lockstep until
+// all of them stopped; stopped lanes keep computing, but their best score is
+// no longer updated.
+
+// one extension per lane, for n <= LANES problems starting at first
+
+inline void
+scoreLanes(ExtensionBatch & batch, unsigned const first, unsigned const n)
+{
+    typedef TSimd::TVec TVec;
+    unsigned const L = TSimd::LANES;
+    int const NEG = INT_MIN / 4;
+
+    ExtensionParams const & params = batch.params;
+    long const up = params.upperDiag;
+    long const lo = params.lowerDiag;
+    long const W = up - lo + 1;
+    long const X = params.xDropOff;
+    int const * scores = batch.scores;
+
+    // per lane state
+    int hLen[L], vLen[L], extra[L], lastCell[L], active[L], best[L];
+    long cols = 0;
+    for (unsigned k = 0; k < L; ++k)
+    {
+        hLen[k] = 0;
+        vLen[k] = 0;
+        extra[k] = -1;
+        active[k] = 0;
+        best[k] = 0;
+        lastCell[k] = 0;
+        if (k >= n)
+            continue;
+
+        ExtensionBatch::Problem const & p = batch.problems[first + k];
+        hLen[k] = p.hLen;
+        vLen[k] = p.vLen;
+        // seqan's banded DP only does single cell for one column
+        active[k] = (p.hLen > 1) ? -1 : 0;
+        if (active[k])
+            cols = std::max(cols, (long)p.hStored);
+        // see extensionScore()
+        if (params.xDrop)
+        {
+            long top = std::min((long)p.hLen - 1, std::max(0l, up));
+            long mid = std::min((long)p.hLen - 1, std::max(0l, (long)p.vLen + lo));
+            if (up > (long)p.vLen + lo)
+                extra[k] = std::min(top, mid);
+            else if (lo + (long)p.vLen < (long)p.hLen)
+                extra[k] = mid;
+        }
+        long const lastRow = std::min((long)p.vLen, -lo);
+        lastCell[k] = (lastRow == 0) ? 0 : params.gapOpen + (lastRow - 1) * params.gapExtend;
+    }
+    long const rows = cols - lo;
+
+    // the x-drop check of the initial column (colMax is 0) only stops all lanes
+    if (!params.xDrop || (X > 0))
+    {
+        batch.hOrds.assign(cols * L, 0);
+        batch.vOrds.assign(rows * L, 0);
+        for (unsigned k = 0; k < n; ++k)
+        {
+            ExtensionBatch::Problem const & p = batch.problems[first + k];
+            if (!active[k])
+                continue;
+            for (unsigned j = 0; j < p.hStored; ++j)
+                batch.hOrds[j * L + k] = batch.hRows[p.hBegin + j];
+            for (unsigned i = 0; i < p.vStored; ++i)
+                batch.vOrds[i * L + k] = batch.ords[p.vBegin + i];
+        }
+
+        batch.cells.assign(2 * (W + 1) * L, NEG);
+        int * H = &batch.cells[0];
+        int * E = H + (W + 1) * L;
+        for (long t = up; t < W; ++t)
+        {
+            long const i = t - up;
+            for (unsigned k = 0; k < L; ++k)
+                if (i <= vLen[k])
+                    H[t * L + k] = (i == 0) ? 0 : params.gapOpen + (i - 1) * params.gapExtend;
+        }
+
+        TVec const negV    = TSimd::set1(NEG);
+        TVec const openV   = TSimd::set1(params.gapOpen);
+        TVec const extV    = TSimd::set1(params.gapExtend);
+        TVec const xMinus1 = TSimd::set1(X - 1);
+        TVec const hLenV   = TSimd::load(hLen);
+        TVec const vLenV   = TSimd::load(vLen);
+        TVec const extraV  = TSimd::load(extra);
+        TVec       activeV = TSimd::load(active);
+        TVec       bestV   = TSimd::set1(0);
+        TVec       pending = TSimd::set1(0);
+
+        if (params.xDrop)
+            pending = TSimd::and_(TSimd::and_(activeV, TSimd::eq(extraV, TSimd::set1(0))),
+                                  TSimd::gt(TSimd::sub(bestV, TSimd::load(lastCell)), xMinus1));
+
+        for (long j = 1; j <= cols; ++j)
+        {
+            // lanes whose band left the matrix
+            activeV = TSimd::andNot(TSimd::gt(TSimd::set1(j - up), vLenV), activeV);
+            if (!TSimd::any(activeV))
+                break;
+
+            long const tBegin = std::max(0l, up - j);
+            TVec const hOrd = TSimd::load(&batch.hOrds[(j - 1) * L]);
+            TVec const lastRowV = TSimd::min(vLenV, TSimd::set1(j - lo));
+            TVec f       = negV;
+            TVec hAbove  = negV;
+            TVec colMax  = negV;
+            TVec lastV   = negV;
+            for (long t = tBegin; t < W; ++t)
+            {
+                long const i = j - up + t;
+                TVec const hLeft = TSimd::load(H + (t + 1) * L);
+                TVec const eLeft = TSimd::load(E + (t + 1) * L);
+
+                TVec eCur = TSimd::max(TSimd::add(hLeft, openV), TSimd::add(eLeft, extV));
+                TVec const fCur = (t > tBegin) ? TSimd::max(TSimd::add(hAbove, openV), TSimd::add(f, extV)) : negV;
+                TVec hCur = TSimd::max(eCur, fCur);
+                if (i > 0)
+                {
+                    TVec const sub = TSimd::gather(scores, TSimd::add(hOrd, TSimd::load(&batch.vOrds[(i - 1) * L])));
+                    hCur = TSimd::max(hCur, TSimd::add(TSimd::load(H + t * L), sub));
+                }
+                TVec const iV = TSimd::set1(i);
+                TVec const valid = TSimd::gt(TSimd::add(vLenV, TSimd::set1(1)), iV);
+                hCur = TSimd::blend(negV, hCur, valid);
+                eCur = TSimd::blend(negV, eCur, valid);
+
+                TSimd::store(H + t * L, hCur);
+                TSimd::store(E + t * L, eCur);
+                f = fCur;
+                hAbove = hCur;
+                colMax = TSimd::max(colMax, hCur);
+                lastV = TSimd::blend(lastV, hCur, TSimd::eq(lastRowV, iV));
+            }
+
+            bestV = TSimd::blend(bestV, TSimd::max(bestV, colMax), activeV);
+
+            TVec const jV = TSimd::set1(j);
+            TVec stop = TSimd::or_(pending, TSimd::eq(hLenV, jV));
+            if (params.xDrop)
+            {
+                TVec const drop = TSimd::gt(TSimd::sub(bestV, colMax), xMinus1);
+                pending = TSimd::andNot(TSimd::or_(drop, pending),
+                                        TSimd::and_(TSimd::eq(extraV, jV),
+                                                    TSimd::gt(TSimd::sub(bestV, lastV), xMinus1)));
+                stop = TSimd::or_(stop, drop);
+            }
+            activeV = TSimd::andNot(stop, activeV);
+            pending = TSimd::and_(pending, activeV);
+            if (!TSimd::any(activeV))
+                break;
+        }
+        TSimd::store(best, bestV);
+    }
+
+    for (unsigned k = 0; k < n; ++k)
+        batch.problems[first + k].score = best[k];
+}
+
+// ----------------------------------------------------------------------------
+// Function scoreStrips()
+// ----------------------------------------------------------------------------
+
+// One extension, computed in strips of LANES columns. Lane k works on column
+// c0 + k and lags k rows behind lane 0, so every step computes one
+// anti-diagonal of the strip and gets the left and diagonal predecessors by
+// shifting the results of the last two steps one lane up. The x-drop checks
+// are done for the columns of a strip in order, after the strip is complete.
+//
+// hOrds holds the offsets of the score rows of h[j] in scores followed by
+// LANES zeros, vRev holds LANES zeros, the first vStored values of v reversed
+// and LANES zeros again (see _scoreStrips()); rows behind vStored are never
+// reached.
+
+inline int
+scoreStrips(int const * scores, int const * hOrds, unsigned const hLen, int const * vRev, unsigned const vStored,
+            unsigned const vLen, ExtensionParams const & params, ExtensionScratch & scratch)
+{
+    typedef TSimd::TVec TVec;
+    unsigned const L = TSimd::LANES;
+    int const NEG = INT_MIN / 4;
+    long const X = params.xDropOff;
+
+    // rows of column j are [rowBegin(j), rowEnd(j))
+    auto rowBegin = [&] (long const j) -> long
+    {
+        return params.banded ? std::max(0l, j - params.upperDiag) : 0l;
+    };
+    auto rowEnd = [&] (long const j) -> long
+    {
+        return params.banded ? std::min((long)vLen, j - params.lowerDiag) + 1 : (long)vLen + 1;
+    };
+
+    // see _extensionScoreScalar()
+    if (params.banded && (hLen == 1))
+        return 0;
+
+    long extraCheck = -1;
+    if (params.banded && params.xDrop)
+    {
+        long const V = vLen;
+        long const up = params.upperDiag;
+        long const lo = params.lowerDiag;
+        long top = std::min((long)hLen - 1, std::max(0l, up));
+        long mid = std::min((long)hLen - 1, std::max(0l, V + lo));
+        if (up > V + lo)
+            extraCheck = std::min(top, mid);
+        else if (lo + V < (long)hLen)
+            extraCheck = mid;
+    }
+
+    // H and E of the column before the strip, row -1 included
+    scratch.h.assign(vStored + L + 2, NEG);
+    scratch.e.assign(vStored + L + 2, NEG);
+    int * P  = &scratch.h[1];
+    int * PE = &scratch.e[1];
+
+    int best = 0;
+    bool terminated = false;
+
+    // initial column: vertical gaps only
+    {
+        long const b = rowBegin(0);
+        long const e = rowEnd(0);
+        if (b > 0 || e <= 0) // band does not contain the origin
+            return 0;
+        P[0] = 0;
+        int colMax = 0;
+        for (long i = 1; i < e; ++i)
+        {
+            P[i] = params.gapOpen + (i - 1) * params.gapExtend;
+            colMax = std::max(colMax, P[i]);
+        }
+        if (params.xDrop && params.banded && (best - colMax >= X))
+            return best;
+        if ((extraCheck == 0) && (best - P[e - 1] >= X))
+            terminated = true;
+    }
+
+    TVec const negV  = TSimd::set1(NEG);
+    TVec const openV = TSimd::set1(params.gapOpen);
+    TVec const extV  = TSimd::set1(params.gapExtend);
+    TVec const laneV = TSimd::laneIndex();
+
+    int rowBegins[L], rowEnds[L], colMaxes[L], lastCells[L], hLast[L], eLast[L];
+
+    for (long c0 = 1; c0 <= (long)hLen; c0 += L)
+    {
+        long const cLast = std::min(c0 + L - 1, (long)hLen);
+        for (unsigned k = 0; k < L; ++k)
+        {
+            long const c = c0 + k;
+            rowBegins[k] = (c <= cLast) ? rowBegin(c) : 0;
+            rowEnds[k]   = (c <= cLast) ? rowEnd(c)   : 0;
+        }
+        long const rStart = rowBegin(c0);
+        long const rEnd   = rowEnd(cLast);
+
+        TVec const rbMinus1 = TSimd::sub(TSimd::load(rowBegins), TSimd::set1(1));
+        TVec const reV      = TSimd::load(rowEnds);
+        TVec const lastRowV = TSimd::sub(reV, TSimd::set1(1));
+        TVec const hOrd     = TSimd::load(hOrds + c0 - 1);
+
+        TVec h1 = negV;     // H of the last step, i.e. H[r - 1][c]
+        TVec h2 = negV;     // H of the step before
+        TVec e1 = negV;
+        TVec f  = negV;
+        TVec colMax = negV;
+        TVec lastV  = negV;
+        for (long s = rStart; s <= rEnd + L - 2; ++s)
+        {
+            TVec const left  = TSimd::shiftIn(h1, P[s]);
+            TVec const diag  = TSimd::shiftIn(h2, P[s - 1]);
+            TVec const eLeft = TSimd::shiftIn(e1, PE[s]);
+            TVec const rV    = TSimd::sub(TSimd::set1(s), laneV);
+            TVec const valid = TSimd::and_(TSimd::gt(rV, rbMinus1), TSimd::gt(reV, rV));
+
+            TVec eCur = TSimd::max(TSimd::add(left, openV), TSimd::add(eLeft, extV));
+            TVec fCur = TSimd::max(TSimd::add(h1, openV), TSimd::add(f, extV));
+            TVec const sub = TSimd::gather(scores, TSimd::add(hOrd, TSimd::load(vRev + vStored + L - s)));
+            TVec hCur = TSimd::max(TSimd::max(eCur, fCur), TSimd::add(diag, sub));
+            hCur = TSimd::blend(negV, hCur, valid);
+            eCur = TSimd::blend(negV, eCur, valid);
+            fCur = TSimd::blend(negV, fCur, valid);
+
+            colMax = TSimd::max(colMax, hCur);
+            lastV = TSimd::blend(lastV, hCur, TSimd::eq(rV, lastRowV));
+
+            // the last lane's column is the previous column of the next strip
+            long const rL = s - (L - 1);
+            if ((rL >= 0) && (rL <= (long)vLen))
+            {
+                TSimd::store(hLast, hCur);
+                TSimd::store(eLast, eCur);
+                P[rL]  = hLast[L - 1];
+                PE[rL] = eLast[L - 1];
+            }
+
+            h2 = h1;
+            h1 = hCur;
+            e1 = eCur;
+            f  = fCur;
+        }
+        TSimd::store(colMaxes, colMax);
+        TSimd::store(lastCells, lastV);
+
+        for (long c = c0; c <= cLast; ++c)
+        {
+            unsigned const k = c - c0;
+            if (rowBegins[k] >= rowEnds[k])
+                return best;
+            best = std::max(best, colMaxes[k]);
+
+            if (terminated)
+                return best;
+            if (!params.xDrop)
+                continue;
+            if (best - colMaxes[k] >= X)
+                return best;
+            if ((c == extraCheck) && (best - lastCells[k] >= X))
+                terminated = true;  // still compute the next column
+        }
+    }
+
+    return best;
+}
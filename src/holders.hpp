@@ -29,8 +29,15 @@
 #define SEQAN_LAMBDA_HOLDERS_H_
 
 
+#include <deque>
+#include <list>
+#include <unordered_map>
+
 #include "match.hpp"
 #include "options.hpp"
+#include "output.hpp"
+#include "ungapped.hpp"
+#include "extension.hpp"
 
 // ============================================================================
 // Forwards
@@ -59,11 +66,14 @@ struct StatsHolder
     uint64_t hitsMerged;
     uint64_t hitsTooShort;
     uint64_t hitsMasked;
+    uint64_t hitsFrequentSubjSeed;
+    uint64_t hitsFrequentQrySeed;
 
 // pre-extension
     uint64_t hitsFailedPreExtendTest;
     uint64_t hitsPutativeDuplicate;
     uint64_t hitsPutativeAbundant;
+    uint64_t hitsFailedScoreBoundTest;
 
 // post-extension
     uint64_t hitsFailedExtendPercentIdentTest;
@@ -75,6 +85,10 @@ struct StatsHolder
     uint64_t hitsFinal;
     uint64_t qrysWithHit;
 
+// seed cache (single index), see SeedIntervalCache
+    uint64_t seedCacheLookups;
+    uint64_t seedCacheHits;
+
     StatsHolder()
     {
         clear();
@@ -86,10 +100,13 @@ struct StatsHolder
         hitsMerged = 0;
         hitsTooShort = 0;
         hitsMasked = 0;
+        hitsFrequentSubjSeed = 0;
+        hitsFrequentQrySeed = 0;
 
         hitsFailedPreExtendTest = 0;
         hitsPutativeDuplicate = 0;
         hitsPutativeAbundant = 0;
+        hitsFailedScoreBoundTest = 0;
 
         hitsFailedExtendPercentIdentTest = 0;
         hitsFailedExtendEValueTest = 0;
@@ -98,6 +115,9 @@ struct StatsHolder
 
         hitsFinal = 0;
         qrysWithHit = 0;
+
+        seedCacheLookups = 0;
+        seedCacheHits = 0;
     }
 
     StatsHolder plus(StatsHolder const & rhs)
@@ -106,10 +126,13 @@ struct StatsHolder
         hitsMerged += rhs.hitsMerged;
         hitsTooShort += rhs.hitsTooShort;
         hitsMasked += rhs.hitsMasked;
+        hitsFrequentSubjSeed += rhs.hitsFrequentSubjSeed;
+        hitsFrequentQrySeed += rhs.hitsFrequentQrySeed;
 
         hitsFailedPreExtendTest += rhs.hitsFailedPreExtendTest;
         hitsPutativeDuplicate += rhs.hitsPutativeDuplicate;
         hitsPutativeAbundant += rhs.hitsPutativeAbundant;
+        hitsFailedScoreBoundTest += rhs.hitsFailedScoreBoundTest;
 
         hitsFailedExtendPercentIdentTest += rhs.hitsFailedExtendPercentIdentTest;
         hitsFailedExtendEValueTest += rhs.hitsFailedExtendEValueTest;
@@ -118,6 +141,9 @@ struct StatsHolder
 
         hitsFinal += rhs.hitsFinal;
         qrysWithHit += rhs.qrysWithHit;
+
+        seedCacheLookups += rhs.seedCacheLookups;
+        seedCacheHits += rhs.seedCacheHits;
         return *this;
     }
 
@@ -192,6 +218,8 @@ public:
     /* INDECES AND THEIR TYPE */
     static constexpr bool
     indexIsFM           = std::is_same<TIndexSpec_, TFMIndex<>>::value;
+    static constexpr bool
+    indexIsKmer         = std::is_same<TIndexSpec_, TKmerIndex>::value;
     using TIndexSpec    = TIndexSpec_;
     using TDbIndex      = Index<typename std::remove_reference<TRedSubjSeqs>::type, TIndexSpec>;
 
@@ -213,21 +241,144 @@ public:
     TQryIds             qryIds;
     TSubjIds            subjIds;
 
+    // QUERY FILE, kept open between chunks //
+    SeqFileIn           qryFile;
+    bool                qryFileParallel = false; // read at once by myReadRecordsParallel()
+    uint64_t            qryChunk = 0; // number of chunks loaded so far
+    uint64_t            qryIdOffset = 0; // number of queries in previous chunks
+
     // OUTPUT FILE //
     using TScoreScheme  = TScoreScheme_;
     using TIOContext    = BlastIOContext<TScoreScheme, p, h>;
     using TFile         = typename std::conditional<std::is_same<TFileFormat, BlastTabular>::value,
                                                     BlastTabularFileOut<TIOContext>,
                                                     BlastReportFileOut<TIOContext>>::type;
+    using TFormat       = TFileFormat;
+    // streams beneath outfile for parallel gzip output, declared first so
+    // that they are destroyed after outfile (see openOutput())
+    std::ofstream                   outRawStream;
+    std::unique_ptr<BgzfOutStream>  outBgzfStream;
     TFile               outfile;
+    OutputWriter<TFile> writer;
+    std::vector<BlastMatchField<>::Enum> outColumnPlan; // see makeTabularColumnPlan()
+    uint64_t            blockOffset = 0; // number of blocks in previous query chunks
+
+    // SCORING //
+    UngappedScoreTable  ungappedTable; // see prepareScoring()
+    // by query length (divided by 3 if translated) for the lengths of the
+    // current query chunk, see prepareEValues()
+    std::vector<uint64_t>   lengthAdjustments;
+    std::vector<int>        minRawScores; // lowest raw score that passes options.eCutOff
+    // BLASTN with match/mismatch scores pre-scores on 2-bit sequences, see
+    // prepareScoring() and ungappedScorePacked()
+    bool                packedScoring = false;
+    int                 packedMatch = 0;
+    int                 packedMismatch = 0;
+    PackedDna           packedQrySeqs;  // of the current query chunk
+    PackedDna           packedSubjSeqs;
 
     StatsHolder                 stats;
 
     GlobalDataHolder() :
-        redQrySeqs(qrySeqs), redSubjSeqs(subjSeqs), stats()
+        redQrySeqs(qrySeqs), redSubjSeqs(subjSeqs), writer(outfile), stats()
     {}
 };
 
+// ----------------------------------------------------------------------------
+// struct LambdaBlastMatch
+// ----------------------------------------------------------------------------
+
+// BlastMatch that remembers the number of its subject, needed for binary
+// output which refers to subjects by index instead of by id
+template <typename TAlignRow0, typename TAlignRow1, typename TPos, typename TQId, typename TSId>
+struct LambdaBlastMatch : public BlastMatch<TAlignRow0, TAlignRow1, TPos, TQId, TSId>
+{
+    using BlastMatch<TAlignRow0, TAlignRow1, TPos, TQId, TSId>::BlastMatch;
+
+    uint64_t subjIdx = 0;
+};
+
+// ----------------------------------------------------------------------------
+// struct ExtensionCandidate
+// ----------------------------------------------------------------------------
+
+// a match whose aligned center was added to LocalDataHolder::extBatch; it is
+// kept after the batch is scored until the match is processed
+struct ExtensionCandidate
+{
+    Match const *   match;
+    uint32_t        qStart;
+    uint32_t        sStart;
+    uint32_t        qEnd;
+    uint32_t        sEnd;
+    int             left;   // index of the problem in the batch or -1
+    int             right;
+    int             score;  // left + right, once the batch is scored
+    int             center; // index in LocalDataHolder::extCenters or -1
+};
+
+// ----------------------------------------------------------------------------
+// struct ExtensionCenter
+// ----------------------------------------------------------------------------
+
+// the center of a match as aligned by the look-ahead of _extensionScore(), so
+// that computeBlastMatch() doesn't align it again
+template <typename TAlignRow0, typename TAlignRow1>
+struct ExtensionCenter
+{
+    TAlignRow0  alignRow0;
+    TAlignRow1  alignRow1;
+    uint32_t    qStart;
+    uint32_t    qEnd;
+    uint32_t    sStart;
+    uint32_t    sEnd;
+    // the ends of the merged seeds before alignment
+    uint32_t    seedQEnd;
+    uint32_t    seedSEnd;
+    int         score;      // of _alignCenter()
+};
+
+// ----------------------------------------------------------------------------
+// struct RecordMatches
+// ----------------------------------------------------------------------------
+
+// the matches of the record a thread is working on. The BlastMatch objects
+// stay in store and are reused for later matches and records (see
+// newBlastMatch()), so their gap arrays keep their memory. order holds the
+// live matches in the order of the record together with their bit-score, so
+// that sorting, removing duplicates and truncating work on a flat array.
+template <typename TBlastMatch>
+struct RecordMatches
+{
+    struct Entry
+    {
+        double      bitScore;
+        uint32_t    slot;       // in store
+    };
+
+    std::deque<TBlastMatch>     store;      // references stay valid on growth
+    std::vector<uint32_t>       freeSlots;
+    std::vector<Entry>          order;
+};
+
+// ----------------------------------------------------------------------------
+// struct SeedIntervalCache
+// ----------------------------------------------------------------------------
+
+// the SA intervals that the backtracking found for a seed, by the packed seed
+// of generateSeeds(); used without query index, where the same seeds are
+// searched again for many queries. Holds at most capacity seeds and starts
+// over when it is full.
+struct SeedIntervalCache
+{
+    using TInterval = std::pair<uint64_t, uint64_t>;   // [begin, end) in the SA
+
+    // seed -> first interval and number of intervals
+    std::unordered_map<uint64_t, std::pair<uint64_t, uint64_t>> seeds;
+    std::vector<TInterval>  intervals;
+    uint64_t                capacity = 0;
+};
+
 // ----------------------------------------------------------------------------
 // struct LocalDataHolder  -- one object per thread
 // ----------------------------------------------------------------------------
@@ -263,6 +414,10 @@ public:
     std::vector<TMatch>   matches;
     std::vector<typename Match::TQId>   seedRefs;  // mapping seed -> query
     std::vector<uint16_t>               seedRanks; // mapping seed -> relative rank
+    std::vector<uint64_t>               seedCodes; // packed seeds, see generateSeeds()
+    SeedIntervalCache                   seedCache; // kept between blocks
+    // hits of the current seed, see __searchPigeonhole()
+    String<typename SAValue<typename TGlobalHolder::TDbIndex>::Type> seedOccs;
 
     // regarding extension
     using TAlignRow0 = Gaps<typename Infix<typename Value<typename TGlobalHolder::TTransQrySeqs>::Type>::Type,
@@ -274,6 +429,36 @@ public:
 
     TAliExtContext      alignContext;
 
+    using TBlastMatch   = LambdaBlastMatch<
+                           TAlignRow0,
+                           TAlignRow1,
+                           uint32_t,
+                           // views into the id sets instead of copies of the ids
+                           typename Infix<typename Concatenator<typename TGlobalHolder::TQryIds>::Type>::Type,
+                           typename Infix<typename Concatenator<typename TGlobalHolder::TSubjIds>::Type>::Type
+                           >;
+    using TBlastRecord  = BlastRecord<TBlastMatch>;
+
+    // the matches of the current record, see RecordMatches
+    RecordMatches<TBlastMatch>  recordMatches;
+    // the record handed to the formatters, its list nodes are kept between
+    // records in outSpare, see makeOutputRecord()
+    TBlastRecord                outRecord;
+    std::list<TBlastMatch>      outSpare;
+
+    // score-only extensions, see _extensionScore()
+    ExtensionBatch                  extBatch;
+    using TExtensionCenter = ExtensionCenter<TAlignRow0, TAlignRow1>;
+    std::vector<ExtensionCandidate> extCandidates;
+    std::vector<TExtensionCenter>   extCenters;     // only grows, see _freeCenterSlot()
+    ExtensionScratch                extScratch;
+    // all frames of one query, see queryProfile()
+    QueryProfile                    qryProfile;
+
+
+    // regarding output, records are formatted locally and handed to gH.writer
+    typename TGlobalHolder::TIOContext outContext;
+    OutputChunk         outChunk;
 
     // regarding the gathering of stats
     StatsHolder         stats;
@@ -284,13 +469,17 @@ public:
     // constructor
     LocalDataHolder(LambdaOptions     const & _options,
                     TGlobalHolder     /*const*/ & _globalHolder) :
-        options(_options), gH(_globalHolder), stats()
-    {}
+        options(_options), gH(_globalHolder), outContext(context(_globalHolder.outfile)), outChunk{"", 0, 0, false}, stats()
+    {
+        seedCache.capacity = options.seedCacheSize;
+    }
 
     // copy constructor SHALLOW COPY ONLY, REQUIRED FOR firsprivate()
     LocalDataHolder(LocalDataHolder const & rhs) :
-        options(rhs.options), gH(rhs.gH), stats()
-    {}
+        options(rhs.options), gH(rhs.gH), outContext(rhs.outContext), outChunk{"", 0, 0, false}, stats()
+    {
+        seedCache.capacity = options.seedCacheSize;
+    }
 
     void init(uint64_t const _i)
     {
@@ -314,8 +503,19 @@ public:
         clear(seeds);
         clear(seedIndex);
         matches.clear();
+        extCandidates.clear();
         seedRefs.clear();
         seedRanks.clear();
+        seedCodes.clear();
+        clear(seedOccs);
+        // keep what a typical record needs, large records of a previous
+        // block should not hold on to their memory
+        clear(recordMatches, 2 * options.maxMatches + 2);
+        // the pre-scoring of a single query uses its profile, see seedLooksPromising()
+        if (!options.doubleIndexing && (options.preScoring > 0) && !gH.packedScoring)
+            makeQueryProfile(qryProfile, gH.qrySeqs, indexBeginQry, indexEndQry, gH.ungappedTable);
+        else
+            qryProfile.qryEnd = 0; // ids restart with every query chunk
 //         stats.clear();
         statusStr.clear();
         statusStr.precision(2);
@@ -323,6 +523,174 @@ public:
 
 };
 
+// ----------------------------------------------------------------------------
+// Function queryProfile()
+// ----------------------------------------------------------------------------
+
+// the profile of all frames of the query of qryId; matches are sorted by query,
+// so it is only rebuilt once per query
+template <typename TMatch,
+          typename TGlobalHolder,
+          typename TScoreExtension>
+inline QueryProfile const &
+queryProfile(LocalDataHolder<TMatch, TGlobalHolder, TScoreExtension> & lH, uint64_t const qryId)
+{
+    uint64_t const qryBegin = qryId - qryId % qNumFrames(TGlobalHolder::blastProgram);
+    if ((lH.qryProfile.qryEnd == 0) || (lH.qryProfile.qryBegin != qryBegin))
+        makeQueryProfile(lH.qryProfile, lH.gH.qrySeqs, qryBegin, qryBegin + qNumFrames(TGlobalHolder::blastProgram),
+                         lH.gH.ungappedTable);
+    return lH.qryProfile;
+}
+
+// ----------------------------------------------------------------------------
+// Function clear()
+// ----------------------------------------------------------------------------
+
+// removes all matches and keeps at most keep objects for reuse
+template <typename TBlastMatch>
+inline void
+clear(RecordMatches<TBlastMatch> & rm, uint64_t const keep)
+{
+    rm.order.clear();
+    if (rm.store.size() > keep)
+        rm.store.resize(keep);
+    rm.freeSlots.resize(rm.store.size());
+    // lowest slots first
+    for (uint32_t i = 0; i < rm.freeSlots.size(); ++i)
+        rm.freeSlots[i] = rm.freeSlots.size() - 1 - i;
+}
+
+// ----------------------------------------------------------------------------
+// Function newBlastMatch()
+// ----------------------------------------------------------------------------
+
+// appends a match to the record, reusing a free object if possible; only the
+// members that are not always set before use are reset, the rows are
+// re-assigned by _alignCenter()
+template <typename TBlastMatch, typename TQId, typename TSId>
+inline TBlastMatch &
+newBlastMatch(RecordMatches<TBlastMatch> & rm, TQId const & qId, TSId const & sId)
+{
+    if (rm.freeSlots.empty())
+    {
+        rm.order.push_back({ 0.0, uint32_t(rm.store.size()) });
+        rm.store.emplace_back(qId, sId);
+        return rm.store.back();
+    }
+
+    rm.order.push_back({ 0.0, rm.freeSlots.back() });
+    rm.freeSlots.pop_back();
+    TBlastMatch & bm = rm.store[rm.order.back().slot];
+    bm.qId          = qId;
+    bm.sId          = sId;
+    bm.eValue       = 0;
+    bm.bitScore     = 0;
+    bm.qFrameShift  = 1;
+    bm.sFrameShift  = 1;
+    clear(bm.alignStats);
+    return bm;
+}
+
+// ----------------------------------------------------------------------------
+// Function blastMatch()
+// ----------------------------------------------------------------------------
+
+// the i-th match of the record
+template <typename TBlastMatch>
+inline TBlastMatch const &
+blastMatch(RecordMatches<TBlastMatch> const & rm, uint64_t const i)
+{
+    return rm.store[rm.order[i].slot];
+}
+
+// ----------------------------------------------------------------------------
+// Function sortBlastMatches()
+// ----------------------------------------------------------------------------
+
+// sorts by descending bit-score, equal ones in the reverse of their current
+// order -- the same order that std::list::sort() gives with BlastMatch's
+// operator<, which is true for equal bit-scores
+template <typename TBlastMatch>
+inline void
+sortBlastMatches(RecordMatches<TBlastMatch> & rm)
+{
+    for (auto & e : rm.order)
+        e.bitScore = rm.store[e.slot].bitScore;
+    std::reverse(rm.order.begin(), rm.order.end());
+    std::stable_sort(rm.order.begin(), rm.order.end(),
+                     [] (typename RecordMatches<TBlastMatch>::Entry const & l,
+                         typename RecordMatches<TBlastMatch>::Entry const & r)
+    {
+        return l.bitScore > r.bitScore;
+    });
+}
+
+// ----------------------------------------------------------------------------
+// Function uniqueBlastMatches()
+// ----------------------------------------------------------------------------
+
+// removes matches that are equal to their predecessor, like std::list::unique()
+template <typename TBlastMatch>
+inline void
+uniqueBlastMatches(RecordMatches<TBlastMatch> & rm)
+{
+    if (rm.order.empty())
+        return;
+    uint64_t kept = 0;
+    for (uint64_t i = 1; i < rm.order.size(); ++i)
+    {
+        if (rm.store[rm.order[i].slot] == rm.store[rm.order[kept].slot])
+            rm.freeSlots.push_back(rm.order[i].slot);
+        else
+            rm.order[++kept] = rm.order[i];
+    }
+    rm.order.resize(kept + 1);
+}
+
+// ----------------------------------------------------------------------------
+// Function truncateBlastMatches()
+// ----------------------------------------------------------------------------
+
+// keeps the first n matches
+template <typename TBlastMatch>
+inline void
+truncateBlastMatches(RecordMatches<TBlastMatch> & rm, uint64_t const n)
+{
+    for (uint64_t i = n; i < rm.order.size(); ++i)
+        rm.freeSlots.push_back(rm.order[i].slot);
+    if (n < rm.order.size())
+        rm.order.resize(n);
+}
+
+// ----------------------------------------------------------------------------
+// Function makeOutputRecord()
+// ----------------------------------------------------------------------------
+
+// copies the matches of the current record to lH.outRecord for the formatters;
+// its list nodes and gap arrays are reused, too
+template <typename TLocalHolder>
+inline void
+makeOutputRecord(TLocalHolder & lH)
+{
+    auto & matches = lH.outRecord.matches;
+    uint64_t const n = lH.recordMatches.order.size();
+    if (matches.size() > n)
+    {
+        lH.outSpare.splice(lH.outSpare.end(), matches, std::next(matches.begin(), n), matches.end());
+    }
+    else
+    {
+        while ((matches.size() < n) && !lH.outSpare.empty())
+            matches.splice(matches.end(), lH.outSpare, lH.outSpare.begin());
+        while (matches.size() < n)
+            matches.emplace_back();
+    }
+
+    uint64_t i = 0;
+    for (auto & bm : matches)
+        bm = blastMatch(lH.recordMatches, i++);
+}
+
 // perform a fast local alignment score calculation on the seed and see if we
 // reach above threshold
 // WARNING the following function only works for hammingdistanced seeds
@@ -370,28 +738,31 @@ seedLooksPromising(
 //                   << effectiveLength << "\n";
     }
 
-    auto const & qSeq = infix(lH.gH.qrySeqs[m.qryId],
-                              effectiveQBegin,
-                              effectiveQBegin + effectiveLength);
     auto const & sSeq = infix(lH.gH.subjSeqs[m.subjId],
                               effectiveSBegin,
                               effectiveSBegin + effectiveLength);
     int maxScore = 0;
-
-    int scores[effectiveLength+1]; // C99, C++14, -Wno-vla before that
-    scores[0] = 0;
-
-    // score the diagonal
-    for (uint64_t i = 0; i < effectiveLength; ++i)
+    if (lH.gH.packedScoring) // BLASTN, positions are in the concatenations
     {
-        scores[i] += score(seqanScheme(context(lH.gH.outfile).scoringScheme), qSeq[i], sSeq[i]);
-        if (scores[i] < 0)
-            scores[i] = 0;
-        else if (scores[i] > maxScore)
-            maxScore = scores[i];
-
-//         if (i < static_cast<uint64_t>(effectiveLength - 1)) // TODO remove
-        scores[i+1] = scores[i];
+        maxScore = ungappedScorePacked(lH.gH.packedQrySeqs,
+                                       stringSetLimits(lH.gH.qrySeqs)[m.qryId] + effectiveQBegin,
+                                       lH.gH.packedSubjSeqs,
+                                       stringSetLimits(lH.gH.subjSeqs)[m.subjId] + effectiveSBegin,
+                                       effectiveLength,
+                                       lH.gH.packedMatch,
+                                       lH.gH.packedMismatch);
+    }
+    // built by init() for the query of this holder
+    else if ((m.qryId >= lH.qryProfile.qryBegin) && (m.qryId < lH.qryProfile.qryEnd))
+    {
+        maxScore = ungappedScore(profileRows(lH.qryProfile, m.qryId, effectiveQBegin), sSeq, effectiveLength);
+    }
+    else
+    {
+        auto const & qSeq = infix(lH.gH.qrySeqs[m.qryId],
+                                  effectiveQBegin,
+                                  effectiveQBegin + effectiveLength);
+        maxScore = ungappedScore(qSeq, sSeq, effectiveLength, lH.gH.ungappedTable);
     }
 
     return (maxScore >= int(lH.options.preScoringThresh * effectiveLength));
@@ -452,16 +823,28 @@ onFindImpl(LocalDataHolder<TMatch, TGlobalHolder, TScoreExtension> & lH,
 template <typename TMatch,
           typename TGlobalHolder,
           typename TScoreExtension,
-          typename TFinder>
+          typename TQryOccs,
+          typename TSubjOccs>
 inline void
 onFindDoubleIndex(LocalDataHolder<TMatch, TGlobalHolder, TScoreExtension> & lH,
-                  TFinder const & finder)
+                  TQryOccs const & qryOccs,
+                  TSubjOccs const & subjOccs)
 {
-    auto qryOccs = getOccurrences(back(finder.patternStack));
-    auto subjOccs = getOccurrences(back(finder.textStack));
-
     lH.stats.hitsAfterSeeding += length(qryOccs) * length(subjOccs);
 
+    // repetitive seeds, the cross product would mostly produce hits that
+    // are thrown away later
+    if ((lH.options.maxSubjSeedOcc != 0) && (length(subjOccs) > lH.options.maxSubjSeedOcc))
+    {
+        lH.stats.hitsFrequentSubjSeed += length(qryOccs) * length(subjOccs);
+        return;
+    }
+    if ((lH.options.maxQrySeedOcc != 0) && (length(qryOccs) > lH.options.maxQrySeedOcc))
+    {
+        lH.stats.hitsFrequentQrySeed += length(qryOccs) * length(subjOccs);
+        return;
+    }
+
     for (unsigned i = 0; i < length(qryOccs); ++i)
         for (unsigned j = 0; j < length(subjOccs); ++j)
             onFindImpl(lH, getSeqNo(qryOccs[i]), subjOccs[j]);
@@ -470,18 +853,33 @@ onFindDoubleIndex(LocalDataHolder<TMatch, TGlobalHolder, TScoreExtension> & lH,
 template <typename TMatch,
           typename TGlobalHolder,
           typename TScoreExtension,
-          typename TSeedListIterator,
-          typename TIndexIterator>
+          typename TFinder>
 inline void
-onFindSingleIndex(LocalDataHolder<TMatch, TGlobalHolder, TScoreExtension> & lH,
-                  TSeedListIterator const & seedIt,
-                  TIndexIterator const & indexIt)
+onFindDoubleIndex(LocalDataHolder<TMatch, TGlobalHolder, TScoreExtension> & lH,
+                  TFinder const & finder)
 {
-    auto qryOcc = position(seedIt);
-    auto subjOccs = getOccurrences(indexIt);
+    onFindDoubleIndex(lH,
+                      getOccurrences(back(finder.patternStack)),
+                      getOccurrences(back(finder.textStack)));
+}
 
+template <typename TMatch,
+          typename TGlobalHolder,
+          typename TScoreExtension,
+          typename TSubjOccs>
+inline void
+onFindSingleIndex(LocalDataHolder<TMatch, TGlobalHolder, TScoreExtension> & lH,
+                  uint64_t const qryOcc,
+                  TSubjOccs const & subjOccs)
+{
     lH.stats.hitsAfterSeeding += length(subjOccs);
 
+    if ((lH.options.maxSubjSeedOcc != 0) && (length(subjOccs) > lH.options.maxSubjSeedOcc))
+    {
+        lH.stats.hitsFrequentSubjSeed += length(subjOccs);
+        return;
+    }
+
     for (unsigned j = 0; j < length(subjOccs); ++j)
         onFindImpl(lH, qryOcc, subjOccs[j]);
 }
@@ -0,0 +1,644 @@
+// ==========================================================================
+//                                  lambda
+// ==========================================================================
+// Copyright (c) 2013-2015, Hannes Hauswedell, FU Berlin
+// All rights reserved.
+//
+// This file is part of Lambda.
+//
+// Lambda is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Lambda is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with Lambda.  If not, see <http://www.gnu.org/licenses/>.*/
+// ==========================================================================
+// Author: Hannes Hauswedell <hannes.hauswedell @ fu-berlin.de>
+// ==========================================================================
+// input.hpp: parallel reading of sequence files
+// ==========================================================================
+
+#ifndef SEQAN_LAMBDA_INPUT_H_
+#define SEQAN_LAMBDA_INPUT_H_
+
+#include <atomic>
+#include <cctype>
+#include <cstring>
+#include <fstream>
+#include <thread>
+#include <string>
+#include <vector>
+
+#if SEQAN_HAS_ZLIB
+#include <zlib.h>
+#endif
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+#include <seqan/basic.h>
+#include <seqan/sequence.h>
+#include <seqan/seq_io.h>
+#include <seqan/file.h>
+
+#include "options.hpp"
+#include "output.hpp" // BoundedQueue
+
+using namespace seqan;
+
+// ============================================================================
+// Functions
+// ============================================================================
+
+// ----------------------------------------------------------------------------
+// Function appendConcatDirect()
+// ----------------------------------------------------------------------------
+
+// append all strings of source to target with one copy of the concat string
+template <typename TString1, typename TSpec1, typename TString2, typename TSpec2>
+inline void
+appendConcatDirect(StringSet<TString1, Owner<ConcatDirect<TSpec1>>>       & target,
+                   StringSet<TString2, Owner<ConcatDirect<TSpec2>>> const & source)
+{
+    uint64_t const offset = length(target.concat);
+    uint64_t const oldLength = length(target);
+    append(target.concat, source.concat);
+    resize(target.limits, oldLength + length(source) + 1);
+    for (uint64_t i = 1; i < length(source.limits); ++i)
+        target.limits[oldLength + i] = offset + source.limits[i];
+}
+
+// ----------------------------------------------------------------------------
+// Function _parseSeqChunk()
+// ----------------------------------------------------------------------------
+
+// parse a piece of text that contains only complete records; the sequences
+// are read in TReadAlph and converted to the alphabet of seqs on appending
+template <typename TReadAlph, typename TSpec1, typename TSeqs>
+inline void
+_parseSeqChunk(TCDStringSet<String<char, TSpec1>> & ids,
+               TSeqs                              & seqs,
+               CharString                   const & text,
+               bool                         const   isFastq)
+{
+    CharString id;
+    String<TReadAlph> seq;
+    auto it = begin(text, Rooted());
+    for (;;)
+    {
+        skipUntil(it, NotFunctor<IsWhitespace>());
+        if (atEnd(it))
+            break;
+        if (isFastq)
+            readRecord(id, seq, it, Fastq());
+        else
+            readRecord(id, seq, it, Fasta());
+        appendValue(ids, id);
+        appendValue(seqs, seq);
+    }
+}
+
+// ----------------------------------------------------------------------------
+// Class FastqCutState
+// ----------------------------------------------------------------------------
+
+// Position in a FASTQ file, carried across blocks by _nextRecordCut().
+// Sequence and quality may span several lines and quality lines may begin
+// with '@' or '+', so a record only ends when as many quality characters as
+// sequence characters have been read.
+
+struct FastqCutState
+{
+    enum Part
+    {
+        BEFORE_RECORD,  // whitespace before the next '@'
+        ID_LINE,
+        SEQ,
+        PLUS_LINE,
+        QUAL
+    };
+
+    Part        part        = BEFORE_RECORD;
+    bool        lineStart   = true;
+    uint64_t    seqLength   = 0;
+    uint64_t    qualLength  = 0;
+};
+
+// ----------------------------------------------------------------------------
+// Function _nextRecordCut()
+// ----------------------------------------------------------------------------
+
+// position in block after which only incomplete records follow
+inline uint64_t
+_nextRecordCut(std::string const & block, bool const isFastq, FastqCutState & state)
+{
+    char const * const b = block.data();
+    char const * const e = b + block.size();
+    if (!isFastq)
+    {
+        // last '\n' that is followed by '>'
+        for (char const * p = e - 1; p > b; --p)
+            if ((*p == '>') && (*(p - 1) == '\n'))
+                return p - b;
+        return 0;
+    }
+
+    uint64_t cut = 0;
+    for (char const * p = b; p < e; ++p)
+    {
+        char const c = *p;
+        if (c == '\n')
+        {
+            state.lineStart = true;
+            if (state.part == FastqCutState::ID_LINE)
+                state.part = FastqCutState::SEQ;
+            else if (state.part == FastqCutState::PLUS_LINE)
+                state.part = FastqCutState::QUAL;
+
+            if ((state.part == FastqCutState::QUAL) && (state.qualLength >= state.seqLength))
+            {
+                cut = p + 1 - b;
+                state = FastqCutState();
+            }
+            continue;
+        }
+
+        bool const lineStart = state.lineStart;
+        state.lineStart = false;
+        switch (state.part)
+        {
+            case FastqCutState::BEFORE_RECORD:
+                if (c == '@')
+                    state.part = FastqCutState::ID_LINE;
+                break;
+            case FastqCutState::SEQ:
+                if (lineStart && (c == '+'))
+                    state.part = FastqCutState::PLUS_LINE;
+                else
+                    state.seqLength += !std::isspace(static_cast<unsigned char>(c));
+                break;
+            case FastqCutState::QUAL:
+                state.qualLength += !std::isspace(static_cast<unsigned char>(c));
+                break;
+            default: // rest of the id and plus line
+                break;
+        }
+    }
+    return cut;
+}
+
+// ----------------------------------------------------------------------------
+// Function _decompressBlocks()
+// ----------------------------------------------------------------------------
+
+// decompress the file and push it into queue in blocks of blockSize; returns
+// false on decompression errors
+#if SEQAN_HAS_ZLIB
+inline bool
+_decompressBlocks(BoundedQueue<std::string>       & queue,
+                  std::atomic<bool>         const & stop,
+                  std::ifstream                   & rawStream,
+                  std::string               const & path,
+                  bool                      const   isBgzf,
+                  unsigned                  const   numThreads,
+                  uint64_t                  const   blockSize)
+{
+    auto pushBlock = [&] (std::string & block)
+    {
+        while (!queue.tryPush(block))
+        {
+            if (stop.load(std::memory_order_relaxed))
+                return false;
+            std::this_thread::yield();
+        }
+        return true;
+    };
+
+    std::string block;
+    if (isBgzf)
+    {
+        basic_unbgzf_streambuf<char> buf(rawStream, std::max(1u, numThreads));
+        for (;;)
+        {
+            block.resize(blockSize);
+            block.resize(buf.sgetn(&block[0], blockSize));
+            if (block.empty() || !pushBlock(block))
+                break;
+        }
+        return true;
+    }
+
+    // zlib reads plain gzip, concatenated members and uncompressed files
+    gzFile gzf = gzopen(path.c_str(), "rb");
+    if (gzf == nullptr)
+        return false;
+    gzbuffer(gzf, 1u << 20);
+    bool success = true;
+    for (;;)
+    {
+        block.resize(blockSize);
+        int const n = gzread(gzf, &block[0], blockSize);
+        if (n < 0)
+            success = false;
+        if (n <= 0)
+            break;
+        block.resize(n);
+        if (!pushBlock(block))
+            break;
+    }
+    gzclose(gzf);
+    return success;
+}
+#endif
+
+// ----------------------------------------------------------------------------
+// Function _findFastaRecordStarts()
+// ----------------------------------------------------------------------------
+
+// append the positions of all '>' in [b, e) that are at the beginning of a line
+// of text (i.e. text[pos-1] == '\n' or pos == 0); scans 16 characters at once
+inline void
+_findFastaRecordStarts(std::vector<uint64_t>       & starts,
+                       char                  const * text,
+                       char                  const * b,
+                       char                  const * e)
+{
+    char const * p = b;
+#ifdef __SSE2__
+    __m128i const gt = _mm_set1_epi8('>');
+    for (; p + 16 <= e; p += 16)
+    {
+        unsigned mask = _mm_movemask_epi8(_mm_cmpeq_epi8(_mm_loadu_si128(reinterpret_cast<__m128i const *>(p)), gt));
+        while (mask)
+        {
+            char const * const q = p + __builtin_ctz(mask);
+            if ((q == text) || (*(q - 1) == '\n'))
+                starts.push_back(q - text);
+            mask &= mask - 1;
+        }
+    }
+#endif
+    for (; p < e; ++p)
+        if ((*p == '>') && ((p == text) || (*(p - 1) == '\n')))
+            starts.push_back(p - text);
+}
+
+// ----------------------------------------------------------------------------
+// Function _myReadRecordsMMap()
+// ----------------------------------------------------------------------------
+
+// Read an uncompressed FASTA file through a memory mapping: record starts are
+// found in parallel, then the lengths of all ids and sequences are counted and
+// finally every thread converts its records directly into the concat strings
+// of ids and seqs, without intermediate buffers. Returns 1 if the file does
+// not look like FASTA.
+
+template <typename TSpec1,
+          typename TAlph,
+          typename TSpec2,
+          typename TReadAlph>
+inline int
+_myReadRecordsMMap(TCDStringSet<String<char, TSpec1>>  & ids,
+                   TCDStringSet<String<TAlph, TSpec2>> & seqs,
+                   std::string                   const & path,
+                   unsigned                      const   numThreads,
+                   TReadAlph                     const & /**/)
+{
+    String<char, MMap<>> file;
+    if (!open(file, path.c_str(), OPEN_RDONLY))
+        throw IOError("Could not open the file.");
+
+    uint64_t const n = length(file);
+    char const * const text = (n > 0) ? &file[0] : nullptr;
+
+    uint64_t firstChar = 0;
+    while ((firstChar < n) && std::isspace(static_cast<unsigned char>(text[firstChar])))
+        ++firstChar;
+    if (firstChar == n) // empty
+        return 0;
+    if (text[firstChar] != '>')
+        return 1;
+
+    // classify every character: 0 -> whitespace, 1 -> residue, 2 -> invalid
+    uint8_t charClass[256];
+    TAlph   convTable[256];
+    IsInAlphabet<TReadAlph> isInAlph;
+    for (unsigned c = 0; c < 256; ++c)
+    {
+        charClass[c] = isInAlph(static_cast<char>(c)) ? 1 : 2;
+        convTable[c] = TAlph(TReadAlph(static_cast<char>(c)));
+    }
+    charClass[uint8_t(' ')] = charClass[uint8_t('\t')] = charClass[uint8_t('\n')] = charClass[uint8_t('\r')] = 0;
+
+    // find record starts
+    unsigned const nThreads = std::max(1u, numThreads);
+    std::vector<std::vector<uint64_t>> threadStarts(nThreads);
+    SEQAN_OMP_PRAGMA(parallel for num_threads(nThreads))
+    for (unsigned t = 0; t < nThreads; ++t)
+        _findFastaRecordStarts(threadStarts[t],
+                               text,
+                               text + (n / nThreads) * t,
+                               (t + 1 == nThreads) ? text + n : text + (n / nThreads) * (t + 1));
+
+    std::vector<uint64_t> starts;
+    // the first '>' may be preceded by whitespace on the same line
+    if ((firstChar != 0) && (text[firstChar - 1] != '\n'))
+        starts.push_back(firstChar);
+    for (auto const & ts : threadStarts)
+        starts.insert(starts.end(), ts.begin(), ts.end());
+    uint64_t const nRecords = starts.size();
+    starts.push_back(n);
+
+    // count lengths
+    std::vector<uint64_t> idEnds(nRecords);
+    std::vector<uint64_t> idLengths(nRecords + 1, 0);
+    std::vector<uint64_t> seqLengths(nRecords + 1, 0);
+    std::vector<uint64_t> badChars(nRecords, 0);
+
+    SEQAN_OMP_PRAGMA(parallel for schedule(dynamic, 256) num_threads(nThreads))
+    for (uint64_t r = 0; r < nRecords; ++r)
+    {
+        uint64_t p = starts[r] + 1;
+        while ((p < starts[r + 1]) && (text[p] != '\n') && (text[p] != '\r'))
+            ++p;
+        idEnds[r] = p;
+        idLengths[r] = p - starts[r] - 1;
+
+        uint64_t len = 0;
+        for (; p < starts[r + 1]; ++p)
+        {
+            uint8_t const cl = charClass[uint8_t(text[p])];
+            len += (cl == 1);
+            if (SEQAN_UNLIKELY(cl == 2) && (badChars[r] == 0))
+                badChars[r] = p + 1;
+        }
+        seqLengths[r] = len;
+    }
+
+    for (uint64_t r = 0; r < nRecords; ++r)
+        if (badChars[r])
+            throw ParseError(std::string("Unexpected character '") + text[badChars[r] - 1] + "' found.");
+
+    // turn lengths into limits (exclusive prefix sums on top of existing content)
+    uint64_t const idOffset  = length(ids);
+    uint64_t const seqOffset = length(seqs);
+    resize(ids.limits, idOffset + nRecords + 1, Exact());
+    resize(seqs.limits, seqOffset + nRecords + 1, Exact());
+    for (uint64_t r = 0; r < nRecords; ++r)
+    {
+        ids.limits[idOffset + r + 1] = ids.limits[idOffset + r] + idLengths[r];
+        seqs.limits[seqOffset + r + 1] = seqs.limits[seqOffset + r] + seqLengths[r];
+    }
+    resize(ids.concat, back(ids.limits), Exact());
+    resize(seqs.concat, back(seqs.limits), Exact());
+
+    // fill concat strings
+    SEQAN_OMP_PRAGMA(parallel for schedule(dynamic, 256) num_threads(nThreads))
+    for (uint64_t r = 0; r < nRecords; ++r)
+    {
+        if (idLengths[r])
+            std::memcpy(&ids.concat[ids.limits[idOffset + r]], text + starts[r] + 1, idLengths[r]);
+
+        auto out = begin(seqs.concat, Standard()) + seqs.limits[seqOffset + r];
+        for (uint64_t p = idEnds[r]; p < starts[r + 1]; ++p)
+        {
+            uint8_t const c = uint8_t(text[p]);
+            if (charClass[c] == 1)
+                *(out++) = convTable[c];
+        }
+    }
+
+    return 0;
+}
+
+// ----------------------------------------------------------------------------
+// Function myReadRecordsParallel()
+// ----------------------------------------------------------------------------
+
+// Read all records of a FASTA/FASTQ file. Uncompressed FASTA is memory mapped
+// (see above). For compressed files one thread decompresses (BGZF with
+// numThreads in parallel) while the text is cut at record boundaries and the
+// pieces are parsed and converted in parallel.
+// Returns 1 if the file is not FASTA/FASTQ or cannot be handled here (this
+// includes uncompressed FASTQ), so that the caller can fall back to SeqFileIn.
+
+template <typename TSpec1,
+          typename TSeqs,
+          typename TReadAlph>
+inline int
+_myReadRecordsParallel(TCDStringSet<String<char, TSpec1>> & ids,
+                       TSeqs                              & seqs,
+                       std::string                  const & path,
+                       unsigned                     const   numThreads,
+                       TReadAlph                    const & /**/)
+{
+    // uncompressed FASTA
+    int ret = _myReadRecordsMMap(ids, seqs, path, numThreads, TReadAlph());
+    if (ret != 1)
+        return ret;
+
+#if SEQAN_HAS_ZLIB
+    static constexpr uint64_t blockSize = 4ull * 1024 * 1024;
+
+    std::ifstream rawStream(path.c_str(), std::ios::binary | std::ios::in);
+    if (!rawStream.is_open())
+        throw IOError("Could not open the file.");
+
+    // BGZF is gzip with a "BC" extra subfield in every member
+    unsigned char header[14] = {0};
+    rawStream.read(reinterpret_cast<char *>(header), 14);
+    bool const isGzip = (rawStream.gcount() >= 2) && (header[0] == 0x1f) && (header[1] == 0x8b);
+    bool const isBgzf = isGzip && (rawStream.gcount() == 14) && (header[3] & 4) &&
+                        (header[12] == 'B') && (header[13] == 'C');
+    rawStream.clear();
+    rawStream.seekg(0);
+
+    // uncompressed, but not FASTA
+    if (!isGzip)
+        return 1;
+
+
+    BoundedQueue<std::string>   queue;
+    queue.init(2 * numThreads + 2);
+    std::atomic<bool>           eof(false);
+    std::atomic<bool>           stop(false);
+    bool                        failed = false;
+
+    std::thread decompressor([&] ()
+    {
+        try
+        {
+            failed = !_decompressBlocks(queue, stop, rawStream, path, isBgzf, numThreads, blockSize);
+        }
+        catch (std::exception const &)
+        {
+            failed = true;
+        }
+        eof.store(true, std::memory_order_release);
+    });
+
+    std::vector<CharString> pieces;
+    CharString              carry;
+    std::string             block;
+    bool                    first = true;
+    bool                    isFastq = false;
+    FastqCutState           fastqState;
+
+    // parse pieces in parallel and append them in order
+    auto parsePieces = [&] ()
+    {
+        std::vector<TCDStringSet<String<char>>> pIds(pieces.size());
+        std::vector<typename std::remove_reference<TSeqs>::type> pSeqs(pieces.size());
+        std::vector<std::string> pErrors(pieces.size());
+
+        SEQAN_OMP_PRAGMA(parallel for schedule(dynamic) num_threads(numThreads))
+        for (uint64_t i = 0; i < pieces.size(); ++i)
+        {
+            try
+            {
+                _parseSeqChunk<TReadAlph>(pIds[i], pSeqs[i], pieces[i], isFastq);
+            }
+            catch (ParseError const & e)
+            {
+                pErrors[i] = e.what();
+            }
+        }
+
+        for (uint64_t i = 0; i < pieces.size(); ++i)
+        {
+            if (!pErrors[i].empty())
+                throw ParseError(pErrors[i]);
+            appendConcatDirect(ids, pIds[i]);
+            appendConcatDirect(seqs, pSeqs[i]);
+        }
+        pieces.clear();
+    };
+
+    try
+    {
+        for (;;)
+        {
+            if (!queue.tryPop(block))
+            {
+                if (!eof.load(std::memory_order_acquire))
+                {
+                    std::this_thread::yield();
+                    continue;
+                }
+                if (!queue.tryPop(block)) // last blocks may arrive just before eof
+                    break;
+            }
+
+            if (first)
+            {
+                first = false;
+                uint64_t p = 0;
+                while ((p < block.size()) && std::isspace(static_cast<unsigned char>(block[p])))
+                    ++p;
+                if ((p == block.size()) || ((block[p] != '>') && (block[p] != '@')))
+                {
+                    // not FASTA/FASTQ, leave to SeqFileIn
+                    stop.store(true, std::memory_order_relaxed);
+                    decompressor.join();
+                    return 1;
+                }
+                isFastq = (block[p] == '@');
+            }
+
+            uint64_t const cut = _nextRecordCut(block, isFastq, fastqState);
+            append(carry, prefix(block, cut));
+            if (!empty(carry) && (cut > 0))
+            {
+                pieces.push_back(carry);
+                clear(carry);
+            }
+            append(carry, suffix(block, cut));
+
+            if (pieces.size() >= numThreads)
+                parsePieces();
+        }
+
+        if (!empty(carry))
+            pieces.push_back(carry);
+        parsePieces();
+    }
+    catch (...)
+    {
+        stop.store(true, std::memory_order_relaxed);
+        decompressor.join();
+        throw;
+    }
+
+    decompressor.join();
+
+    if (failed)
+        throw IOError("Could not decompress the file.");
+
+    return 0;
+#else
+    return 1;
+#endif
+}
+
+template <typename TSpec1,
+          typename TSpec2>
+inline int
+myReadRecordsParallel(TCDStringSet<String<char, TSpec1>> & ids,
+                      TCDStringSet<String<Dna5, TSpec2>> & seqs,
+                      std::string                  const & path,
+                      unsigned                     const   numThreads)
+{
+    try
+    {
+        // all IUPAC nucleic acid characters are valid input
+        return _myReadRecordsParallel(ids, seqs, path, numThreads, Iupac());
+    }
+    catch(ParseError const & e)
+    {
+        std::cerr << "\nParseError thrown: " << e.what() << '\n'
+                  << "Make sure that the file is standards compliant. If you get an unexpected character warning "
+                  << "make sure you have set the right program parameter (-p), i.e. "
+                  << "Lambda expected nucleic acid alphabet, maybe the file was protein?\n";
+        return -1;
+    }
+}
+
+template <typename TSpec1,
+          typename TSpec2>
+inline int
+myReadRecordsParallel(TCDStringSet<String<char, TSpec1>>      & ids,
+                      TCDStringSet<String<AminoAcid, TSpec2>> & seqs,
+                      std::string                       const & path,
+                      unsigned                          const   numThreads)
+{
+    int ret = 0;
+    try
+    {
+        ret = _myReadRecordsParallel(ids, seqs, path, numThreads, AminoAcid());
+    }
+    catch(ParseError const & e)
+    {
+        std::cerr << "\nParseError thrown: " << e.what() << '\n'
+                  << "Make sure that the file is standards compliant.\n";
+        return -1;
+    }
+
+    if ((ret == 0) && (length(seqs) > 0))
+    {
+        // warn if sequences look like DNA
+        if (CharString(String<Dna5>(CharString(seqs[0]))) == CharString(seqs[0]))
+            std::cout << "\nWarning: The first query sequence looks like nucleic acid, but amino acid is expected.\n"
+                         "           Make sure you have set the right program parameter (-p).\n";
+    }
+
+    return ret;
+}
+
+#endif // SEQAN_LAMBDA_INPUT_H_
@@ -0,0 +1,192 @@
+// ==========================================================================
+//                                  lambda
+// ==========================================================================
+// Copyright (c) 2013-2015, Hannes Hauswedell, FU Berlin
+// All rights reserved.
+//
+// This file is part of Lambda.
+//
+// Lambda is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Lambda is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with Lambda.  If not, see <http://www.gnu.org/licenses/>.*/
+// ==========================================================================
+// Author: Hannes Hauswedell <hannes.hauswedell @ fu-berlin.de>
+// ==========================================================================
+// kmer_index.hpp: seeding with a hash table of the database k-mers
+// ==========================================================================
+
+#ifndef SEQAN_LAMBDA_KMER_INDEX_H_
+#define SEQAN_LAMBDA_KMER_INDEX_H_
+
+#include <cstdint>
+#include <numeric>
+
+#include <seqan/basic.h>
+#include <seqan/sequence.h>
+#include <seqan/index.h>
+
+using namespace seqan;
+
+// The k-mer index (TKmerIndex) is a q-gram index of the reduced subject
+// sequences with k = seed length. Its bucket directory is addressed directly
+// by the k-mer code if sigma^k is small, otherwise through an open addressing
+// hash table. Instead of backtracking in a tree, every word within maxDist
+// substitutions of a seed is looked up in the table.
+
+// ----------------------------------------------------------------------------
+// Function _forEachKmer()
+// ----------------------------------------------------------------------------
+
+// calls onKmer(code, seqNo, seqOffset) for every k-mer of the sequences
+template <typename TText, typename TOnKmer>
+inline void
+_forEachKmer(TText const & text, uint64_t const k, TOnKmer && onKmer)
+{
+    using TAlph = typename Value<typename Value<TText>::Type>::Type;
+
+    uint64_t const sigma = ValueSize<TAlph>::VALUE;
+    uint64_t top = 1; // value of the first character in the code
+    for (uint64_t i = 1; i < k; ++i)
+        top *= sigma;
+
+    for (uint64_t seqNo = 0; seqNo < length(text); ++seqNo)
+    {
+        auto const & seq = text[seqNo];
+        if (length(seq) < k)
+            continue;
+
+        uint64_t code = 0;
+        for (uint64_t i = 0; i < k - 1; ++i)
+            code = code * sigma + ordValue(seq[i]);
+        for (uint64_t i = k - 1; i < length(seq); ++i)
+        {
+            code = code * sigma + ordValue(seq[i]);
+            onKmer(code, seqNo, i + 1 - k);
+            code -= ordValue(seq[i + 1 - k]) * top;
+        }
+    }
+}
+
+// ----------------------------------------------------------------------------
+// Function createKmerIndex()
+// ----------------------------------------------------------------------------
+
+// builds the SA and directory fibres of index for k-mers of length k; the
+// q-gram construction of SeqAn can't handle the modified strings of the
+// reduced subjects, so the counting sort is done here
+template <typename TText, typename TSpec>
+inline void
+createKmerIndex(Index<TText, TSpec> & index, uint64_t const k)
+{
+    auto & sa = indexSA(index);
+    auto & dir = indexDir(index);
+    auto & bucketMap = indexBucketMap(index);
+
+    resize(indexShape(index), k);
+    resize(sa, _qgramQGramCount(index), Exact());
+    resize(dir, _fullDirLength(index), Exact()); // decides between hashing and direct addressing
+    _qgramClearDir(dir, bucketMap, Serial());
+
+    // the size of bucket b is counted in dir[b + 1], so that the prefix sums
+    // are the bucket begins
+    _forEachKmer(indexText(index), k, [&dir, &bucketMap] (uint64_t const code, uint64_t, uint64_t)
+    {
+        ++dir[requestBucket(bucketMap, code) + 1];
+    });
+    std::partial_sum(begin(dir, Standard()), end(dir, Standard()), begin(dir, Standard()));
+
+    // dir[b] is moved to the end of bucket b while filling it ...
+    _forEachKmer(indexText(index), k, [&sa, &dir, &bucketMap] (uint64_t const code,
+                                                               uint64_t const seqNo,
+                                                               uint64_t const seqOffset)
+    {
+        auto & occ = sa[dir[getBucket(bucketMap, code)]++];
+        assignValueI1(occ, seqNo);
+        assignValueI2(occ, seqOffset);
+    });
+
+    // ... which is the begin of bucket b + 1
+    for (uint64_t b = length(dir) - 1; b > 0; --b)
+        dir[b] = dir[b - 1];
+    dir[0] = 0;
+}
+
+// ----------------------------------------------------------------------------
+// Function kmerOccurrences()
+// ----------------------------------------------------------------------------
+
+// the occurrences of the k-mer with the given code, empty if there are none
+template <typename TIndex>
+inline typename Infix<typename Fibre<TIndex, FibreSA>::Type const>::Type
+kmerOccurrences(TIndex const & index, uint64_t const code)
+{
+    auto const bucket = getBucket(indexBucketMap(index), code);
+    return infix(indexSA(index), indexDir(index)[bucket], indexDir(index)[bucket + 1]);
+}
+
+// ----------------------------------------------------------------------------
+// Function _kmerNeighbourhood()
+// ----------------------------------------------------------------------------
+
+// code is the code of a word, seed[0..end) are not substituted yet and
+// weight is the value of a character at position end - 1 in the code
+template <typename TIndex, typename TSeed, typename TOnFind>
+inline void
+_kmerNeighbourhood(TIndex const & index,
+                   TSeed const & seed,
+                   uint64_t const code,
+                   uint64_t const end,
+                   uint64_t const weight,
+                   unsigned const maxDist,
+                   TOnFind && onFind)
+{
+    auto const occs = kmerOccurrences(index, code);
+    if (!empty(occs))
+        onFind(occs);
+
+    if (maxDist == 0)
+        return;
+
+    uint64_t const sigma = ValueSize<typename Value<TSeed>::Type>::VALUE;
+    uint64_t w = weight;
+    for (uint64_t i = end; i-- > 0; w *= sigma)
+    {
+        uint64_t const ord = ordValue(seed[i]);
+        uint64_t const base = code - ord * w;
+        for (uint64_t c = 0; c < sigma; ++c)
+            if (c != ord)
+                _kmerNeighbourhood(index, seed, base + c * w, i, w * sigma, maxDist - 1, onFind);
+    }
+}
+
+// ----------------------------------------------------------------------------
+// Function kmerFind()
+// ----------------------------------------------------------------------------
+
+// calls onFind(subjOccs) for every word with at most maxDist mismatches to
+// seed that occurs in the k-mer index; the substituted positions are chosen
+// from right to left and never keep the seed's character, so every word is
+// looked up once, as the backtracking with Hamming distance reports every
+// subject word once
+template <typename TIndex, typename TSeed, typename TOnFind>
+inline void
+kmerFind(TIndex const & index, TSeed const & seed, unsigned const maxDist, TOnFind && onFind)
+{
+    uint64_t const sigma = ValueSize<typename Value<TSeed>::Type>::VALUE;
+    uint64_t code = 0;
+    for (uint64_t i = 0; i < length(seed); ++i)
+        code = code * sigma + ordValue(seed[i]);
+
+    _kmerNeighbourhood(index, seed, code, length(seed), 1, maxDist, onFind);
+}
+
+#endif // SEQAN_LAMBDA_KMER_INDEX_H_
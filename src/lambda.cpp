@@ -175,6 +175,8 @@ argConv0(LambdaOptions const & options)
         return argConv05(options, BlastTabular(), BlastTabularSpecSelector<BlastTabularSpec::NO_COMMENTS>());
     else if (endsWith(output, ".m9"))
         return argConv05(options, BlastTabular(), BlastTabularSpecSelector<BlastTabularSpec::COMMENTS>());
+    else if (endsWith(output, ".m8b")) // records are written by appendBinaryMatch() instead
+        return argConv05(options, BlastTabular(), BlastTabularSpecSelector<BlastTabularSpec::NO_COMMENTS>());
     return -1;
 }
 
@@ -377,6 +379,14 @@ argConv4(LambdaOptions                  const & options,
                                    TRedAlph(),
                                    TScoreScheme(),
                                    TScoreExtension());
+    else if (indexType == 2)
+        return realMain<TKmerIndex>(options,
+                                   TOutFormat(),
+                                   BlastTabularSpecSelector<h>(),
+                                   BlastProgramSelector<p>(),
+                                   TRedAlph(),
+                                   TScoreScheme(),
+                                   TScoreExtension());
     else
         return realMain<TFMIndex<>>(options,
                                    TOutFormat(),
@@ -393,6 +403,103 @@ argConv4(LambdaOptions                  const & options,
 #else
 #define TID 0
 #endif
+
+/// search and extend all queries currently loaded in the globalHolder
+template <typename TLocalHolder,
+          typename TGlobalHolder>
+inline int
+searchChunk(TGlobalHolder                  & globalHolder,
+            LambdaOptions            const & options)
+{
+    if (options.doubleIndexing)
+    {
+        myPrint(options, 1,
+                "Searching ",
+                options.queryPart,
+                " blocks of query with ",
+                options.threads,
+                " threads...\n");
+        if ((options.isTerm) && (options.verbosity >= 1))
+        {
+            for (unsigned char i=0; i< options.threads+3; ++i)
+                std::cout << std::endl;
+            std::cout << "\033[" << options.threads+2 << "A";
+        }
+    } else
+    {
+        myPrint(options, 1, "Searching and extending hits on-line...progress:\n"
+                "0%  10%  20%  30%  40%  50%  60%  70%  80%  90%  100%\n|");
+    }
+
+    // at least a block for each thread on double-indexing,
+    // otherwise a block for each original query (contains 6 queries if
+    // translation is used)
+    uint64_t nBlocks = (options.doubleIndexing
+                        ? options.queryPart
+                        : length(globalHolder.qryIds));
+
+    uint64_t lastPercent = 0;
+
+    SEQAN_OMP_PRAGMA(parallel)
+    {
+        TLocalHolder localHolder(options, globalHolder);
+
+        SEQAN_OMP_PRAGMA(for schedule(dynamic))
+        for (uint64_t t = 0; t < nBlocks; ++t)
+        {
+            int res = 0;
+
+            globalHolder.writer.waitForWindow(globalHolder.blockOffset + t);
+
+            localHolder.init(t);
+
+            // seed
+            res = generateSeeds(localHolder);
+
+            if ((!res) && (options.doubleIndexing))
+                res = generateTrieOverSeeds(localHolder);
+
+            if (!res)
+            {
+                // search
+                search(localHolder);
+
+                // sort
+                sortMatches(localHolder);
+
+                // extend
+                res = iterateMatches(localHolder);
+            }
+
+            // output of this block is complete (possibly empty)
+            flushOutput(localHolder, true);
+
+            if (res)
+                continue;
+
+            if ((!options.doubleIndexing) && (TID == 0) &&
+                (options.verbosity >= 1))
+            {
+                unsigned curPercent = ((t * 50) / nBlocks) * 2; // round to even
+                printProgressBar(lastPercent, curPercent);
+            }
+
+        } // implicit thread sync here
+
+        if ((!options.doubleIndexing) && (TID == 0) && (options.verbosity >= 1))
+            printProgressBar(lastPercent, 100);
+
+        SEQAN_OMP_PRAGMA(critical(statsAdd))
+        {
+            globalHolder.stats += localHolder.stats;
+        }
+    }
+
+    globalHolder.blockOffset += nBlocks;
+
+    return 0;
+}
+
 template <typename TIndexSpec,
           typename TRedAlph,
           typename TScoreScheme,
@@ -442,7 +549,7 @@ realMain(LambdaOptions                  const & options,
     if (ret)
         return ret;
 
-    ret = loadQuery(globalHolder, options);
+    ret = openQuery(globalHolder, options);
     if (ret)
         return ret;
 
@@ -462,97 +569,45 @@ realMain(LambdaOptions                  const & options,
 //               << back(globalHolder.subjSeqs) << "\n"
 //               << back(globalHolder.redSubjSeqs) << "\n";
 
-    open(globalHolder.outfile, toCString(options.output));
+    ret = openOutput(globalHolder, options);
+    if (ret)
+        return ret;
+
     context(globalHolder.outfile).fields = options.columns;
+    makeTabularColumnPlan(globalHolder.outColumnPlan, options.columns);
     writeHeader(globalHolder.outfile);
+    // all records are written by a separate thread, allow a few chunks per
+    // worker to be in flight (and for ordered output a few blocks per worker
+    // to be finished ahead of the oldest running one)
+    globalHolder.writer.start(4 * options.threads,
+                              options.orderedOutput,
+                              std::max<uint64_t>(64, 16 * options.threads));
 
-    if (options.doubleIndexing)
-    {
-        myPrint(options, 1,
-                "Searching ",
-                options.queryPart,
-                " blocks of query with ",
-                options.threads,
-                " threads...\n");
-        if ((options.isTerm) && (options.verbosity >= 1))
-        {
-            for (unsigned char i=0; i< options.threads+3; ++i)
-                std::cout << std::endl;
-            std::cout << "\033[" << options.threads+2 << "A";
-        }
-    } else
-    {
-        myPrint(options, 1, "Searching and extending hits on-line...progress:\n"
-                "0%  10%  20%  30%  40%  50%  60%  70%  80%  90%  100%\n|");
-    }
     double start = sysTime();
 
-    // at least a block for each thread on double-indexing,
-    // otherwise a block for each original query (contains 6 queries if
-    // translation is used)
-    uint64_t nBlocks = (options.doubleIndexing
-                        ? options.queryPart
-                        : length(globalHolder.qryIds));
-
-    uint64_t lastPercent = 0;
-
-    SEQAN_OMP_PRAGMA(parallel)
+    // with options.queryChunkSize != 0 only a chunk of the queries is held in
+    // memory at a time; results of one chunk are written before the next one
+    // is loaded
+    do
     {
-        TLocalHolder localHolder(options, globalHolder);
-
-        SEQAN_OMP_PRAGMA(for schedule(dynamic))
-        for (uint64_t t = 0; t < nBlocks; ++t)
-        {
-            int res = 0;
-
-            localHolder.init(t);
-
-            // seed
-            res = generateSeeds(localHolder);
-            if (res)
-                continue;
-
-            if (options.doubleIndexing)
-            {
-                res = generateTrieOverSeeds(localHolder);
-                if (res)
-                    continue;
-            }
-
-            // search
-            search(localHolder);
-
-            // sort
-            sortMatches(localHolder);
-
-            // extend
-            res = iterateMatches(localHolder);
-            if (res)
-                continue;
-
-
-            if ((!options.doubleIndexing) && (TID == 0) &&
-                (options.verbosity >= 1))
-            {
-                unsigned curPercent = ((t * 50) / nBlocks) * 2; // round to even
-                printProgressBar(lastPercent, curPercent);
-            }
-
-        } // implicit thread sync here
-
-        if ((!options.doubleIndexing) && (TID == 0) && (options.verbosity >= 1))
-            printProgressBar(lastPercent, 100);
+        ret = loadQuery(globalHolder, options);
+        if (ret)
+            break;
 
-        SEQAN_OMP_PRAGMA(critical(statsAdd))
-        {
-            globalHolder.stats += localHolder.stats;
-        }
-    }
+        ret = searchChunk<TLocalHolder>(globalHolder, options);
+        if (ret)
+            break;
+    } while (!globalHolder.qryFileParallel && !atEnd(globalHolder.qryFile));
 
+    // wait until everything is written
+    if (globalHolder.writer.finish())
+        return -1;
     if (ret)
         return ret;
 
     writeFooter(globalHolder.outfile);
+    close(globalHolder.outfile);
+    globalHolder.outBgzfStream.reset(); // flushes remaining blocks
 
     if (!options.doubleIndexing)
     {
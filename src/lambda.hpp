@@ -28,6 +28,7 @@
 #ifndef SEQAN_LAMBDA_LAMBDA_H_
 #define SEQAN_LAMBDA_LAMBDA_H_
 
+#include <array>
 #include <type_traits>
 #include <iomanip>
 
@@ -50,6 +51,11 @@
 #include "misc.hpp"
 #include "alph.hpp"
 #include "holders.hpp"
+#include "pigeonhole.hpp"
+#include "kmer_index.hpp"
+#include "input.hpp"
+#include "binary_output.hpp"
+#include "tabular_output.hpp"
 
 using namespace seqan;
 
@@ -57,6 +63,7 @@ enum COMPUTERESULT_
 {
     SUCCESS = 0,
     PREEXTEND,
+    SCOREBOUND,
     PERCENTIDENT,
     EVALUE,
     OTHER_FAIL
@@ -137,6 +144,14 @@ prepareScoring(GlobalDataHolder<TRedAlph, TScoreScheme, TIndexSpec, TOutFormat,
                   << "Scoring Scheme. Exiting.\n";
         return -1;
     }
+
+    makeUngappedScoreTable<TransAlph<p>>(globalHolder.ungappedTable,
+                                         seqanScheme(context(globalHolder.outfile).scoringScheme));
+    // the sequences are packed by loadSubjects() and loadQuery()
+    globalHolder.packedScoring = (p == BlastProgram::BLASTN) && (options.preScoring > 0) &&
+                                 simpleScores(globalHolder.packedMatch,
+                                              globalHolder.packedMismatch,
+                                              globalHolder.ungappedTable);
     return 0;
 }
 
@@ -175,6 +190,9 @@ loadSubjects(GlobalDataHolder<TRedAlph, TScoreScheme, TIndexSpec, TOutFormat, p,
     if (TGH::alphReduction)
         globalHolder.redSubjSeqs.limits = globalHolder.subjSeqs.limits;
 
+    if (globalHolder.packedScoring)
+        packDna(globalHolder.packedSubjSeqs, concat(globalHolder.subjSeqs));
+
     double finish = sysTime() - start;
     myPrint(options, 1, " done.\n");
     myPrint(options, 2, "Runtime: ", finish, "s \n", "Amount: ",
@@ -250,6 +268,8 @@ loadDbIndexFromDisk(TGlobalHolder       & globalHolder,
     path += '.' + std::string(_alphName(typename TGlobalHolder::TRedAlph()));
     if (TGlobalHolder::indexIsFM)
         path += ".fm";
+    else if (TGlobalHolder::indexIsKmer) // k-mers of seed length
+        path += ".kmer" + std::to_string(options.seedLength);
     else
         path += ".sa";
     int ret = open(globalHolder.dbIndex, path.c_str());
@@ -476,6 +496,42 @@ loadQueryImplTrans(TCDStringSet<String<TransAlph<BlastProgram::BLASTP>, TSpec1>>
 //     return uint64_t(&str);
 // }
 
+template <BlastTabularSpec h,
+          BlastProgram p,
+          typename TRedAlph,
+          typename TScoreScheme,
+          typename TIndexSpec,
+          typename TOutFormat>
+inline int
+openQuery(GlobalDataHolder<TRedAlph, TScoreScheme, TIndexSpec, TOutFormat, p, h> & globalHolder,
+          LambdaOptions                                                    const & options,
+          bool                                                             const   allowParallel = true)
+{
+    // FASTA and compressed FASTQ are read and parsed in parallel (memory
+    // mapped if uncompressed FASTA), unless queries shall be processed in
+    // chunks; loadQuery() falls back to SeqFileIn for everything else
+    if (allowParallel && (options.queryChunkSize == 0) &&
+        (options.queryFile != "-") && !endsWith(options.queryFile, ".bz2"))
+    {
+        globalHolder.qryFileParallel = true;
+        return 0;
+    }
+
+    try
+    {
+        open(globalHolder.qryFile, toCString(options.queryFile));
+    }
+    catch(IOError const & e)
+    {
+        std::cerr << "\nIOError thrown: " << e.what() << '\n'
+                  << "Could not read the query file, make sure it exists and is readable.\n";
+        return -1;
+    }
+    return 0;
+}
+
+// loads the next options.queryChunkSize sequences (or all if 0) from the
+// query file opened by openQuery(), replacing the previous chunk
 template <BlastTabularSpec h,
           BlastProgram p,
           typename TRedAlph,
@@ -489,16 +545,39 @@ loadQuery(GlobalDataHolder<TRedAlph, TScoreScheme, TIndexSpec, TOutFormat, p, h>
     using TGH = GlobalDataHolder<TRedAlph, TScoreScheme, TIndexSpec, TOutFormat, p, h>;
     double start = sysTime();
 
-    std::string strIdent = "Loading Query Sequences and Ids...";
-    myPrint(options, 1, strIdent);
+    ++globalHolder.qryChunk;
+    if (options.queryChunkSize)
+        myPrint(options, 1, "Loading Query Sequences and Ids (chunk ", globalHolder.qryChunk, ")...");
+    else
+        myPrint(options, 1, "Loading Query Sequences and Ids...");
 
     TCDStringSet<String<OrigQryAlph<p>, typename TGH::TQryTag>> origSeqs;
 
-//     std::cout << "FOO " <<  toCString(options.queryFile) << " BAR" << std::endl;
+    globalHolder.qryIdOffset += length(globalHolder.qryIds);
+    clear(globalHolder.qryIds);
+
+    int ret = 0;
     try
     {
-        SeqFileIn infile(toCString(options.queryFile));
-        int ret = myReadRecords(globalHolder.qryIds, origSeqs, infile);
+        if (globalHolder.qryFileParallel)
+        {
+            ret = myReadRecordsParallel(globalHolder.qryIds, origSeqs, options.queryFile, options.threads);
+            if (ret == 1) // not FASTA/FASTQ, use seqan's reader
+            {
+                globalHolder.qryFileParallel = false;
+                clear(globalHolder.qryIds);
+                clear(origSeqs);
+                ret = openQuery(globalHolder, options, false);
+                if (ret)
+                    return ret;
+            }
+        }
+
+        if (!globalHolder.qryFileParallel)
+            ret = myReadRecords(globalHolder.qryIds,
+                                origSeqs,
+                                globalHolder.qryFile,
+                                options.queryChunkSize ? options.queryChunkSize : MaxValue<uint64_t>::VALUE);
         if (ret)
             return ret;
     }
@@ -522,6 +601,11 @@ loadQuery(GlobalDataHolder<TRedAlph, TScoreScheme, TIndexSpec, TOutFormat, p, h>
     if (TGH::alphReduction)
         globalHolder.redQrySeqs.limits = globalHolder.qrySeqs.limits;
 
+    if (globalHolder.packedScoring)
+        packDna(globalHolder.packedQrySeqs, concat(globalHolder.qrySeqs));
+
+    prepareEValues(globalHolder, options);
+
     double finish = sysTime() - start;
     myPrint(options, 1, " done.\n");
 
@@ -539,6 +623,150 @@ loadQuery(GlobalDataHolder<TRedAlph, TScoreScheme, TIndexSpec, TOutFormat, p, h>
     return 0;
 }
 
+// --------------------------------------------------------------------------
+// Function prepareEValues()
+// --------------------------------------------------------------------------
+
+// the query length that the e-value is computed for
+inline uint64_t
+_eValueQryLength(uint64_t const qLength, BlastProgram const p)
+{
+    return qLength / (qIsTranslated(p) ? 3 : 1);
+}
+
+// Fills the length adjustments and the raw score thresholds for all lengths
+// of the current query chunk, so that e-values are computed without seqan's
+// cache in the context (which needs a lock between threads).
+template <BlastTabularSpec h,
+          BlastProgram p,
+          typename TRedAlph,
+          typename TScoreScheme,
+          typename TIndexSpec,
+          typename TOutFormat>
+inline void
+prepareEValues(GlobalDataHolder<TRedAlph, TScoreScheme, TIndexSpec, TOutFormat, p, h> & globalHolder,
+               LambdaOptions                                                    const & options)
+{
+    auto const & scheme = context(globalHolder.outfile).scoringScheme;
+    uint64_t const dbLength = context(globalHolder.outfile).dbTotalLength;
+
+    std::vector<uint64_t> lengths(length(globalHolder.qrySeqs));
+    for (uint64_t i = 0; i < length(globalHolder.qrySeqs); ++i)
+        lengths[i] = _eValueQryLength(qIsTranslated(p) ? globalHolder.untransQrySeqLengths[i / qNumFrames(p)]
+                                                       : length(globalHolder.qrySeqs[i]),
+                                      p);
+    std::sort(lengths.begin(), lengths.end());
+    lengths.erase(std::unique(lengths.begin(), lengths.end()), lengths.end());
+
+    uint64_t const maxLength = lengths.empty() ? 0 : lengths.back();
+    globalHolder.lengthAdjustments.assign(maxLength + 1, 0);
+    globalHolder.minRawScores.assign(maxLength + 1, 0);
+
+    for (uint64_t const ql : lengths)
+    {
+        uint64_t const adj = _lengthAdjustment(dbLength, ql, scheme);
+        globalHolder.lengthAdjustments[ql] = adj;
+
+        // the e-value falls with the score, start at the solution of
+        // e(s) = eCutOff and correct the rounding with the exact function
+        auto eValue = [&] (int const s)
+        {
+            return _computeEValue(s, ql - adj, dbLength - adj, scheme);
+        };
+        double const guess = std::log(getKappa(scheme) * double(ql - adj) * double(dbLength - adj) /
+                                      options.eCutOff) / getLambda(scheme);
+        int s = std::isfinite(guess) ? int(std::max(-1e6, std::min(1e6, std::ceil(guess)))) : 0;
+        while (eValue(s) > options.eCutOff)
+            ++s;
+        while ((s > -1000000) && (eValue(s - 1) <= options.eCutOff))
+            --s;
+        globalHolder.minRawScores[ql] = s;
+    }
+}
+
+// --------------------------------------------------------------------------
+// Function computeEValue()
+// --------------------------------------------------------------------------
+
+// same as seqan's computeEValue(match, context), but with the length
+// adjustment of prepareEValues()
+template <typename TBlastMatch,
+          BlastTabularSpec h,
+          BlastProgram p,
+          typename TRedAlph,
+          typename TScoreScheme,
+          typename TIndexSpec,
+          typename TOutFormat>
+inline double
+computeEValue(TBlastMatch                                                           & match,
+              GlobalDataHolder<TRedAlph, TScoreScheme, TIndexSpec, TOutFormat, p, h> const & globalHolder)
+{
+    uint64_t const ql = _eValueQryLength(match.qLength, p);
+    uint64_t const adj = globalHolder.lengthAdjustments[ql];
+    match.eValue = _computeEValue(match.alignStats.alignmentScore,
+                                  ql - adj,
+                                  context(globalHolder.outfile).dbTotalLength - adj,
+                                  context(globalHolder.outfile).scoringScheme);
+    return match.eValue;
+}
+
+// --------------------------------------------------------------------------
+// Function openOutput()
+// --------------------------------------------------------------------------
+
+template <BlastTabularSpec h,
+          BlastProgram p,
+          typename TRedAlph,
+          typename TScoreScheme,
+          typename TIndexSpec,
+          typename TOutFormat>
+inline int
+openOutput(GlobalDataHolder<TRedAlph, TScoreScheme, TIndexSpec, TOutFormat, p, h> & globalHolder,
+           LambdaOptions                                                    const & options)
+{
+    using TGH = GlobalDataHolder<TRedAlph, TScoreScheme, TIndexSpec, TOutFormat, p, h>;
+
+    bool success = false;
+    if (endsWith(options.output, ".gz"))
+    {
+        // block-parallel compression, readable by any gzip reader
+        globalHolder.outRawStream.open(options.output.c_str(), std::ios::binary | std::ios::out);
+        if (globalHolder.outRawStream.is_open())
+        {
+            globalHolder.outBgzfStream.reset(new BgzfOutStream(globalHolder.outRawStream,
+                                                               std::max<size_t>(1, options.threads)));
+            success = open(globalHolder.outfile, *globalHolder.outBgzfStream, typename TGH::TFormat());
+        }
+    }
+    else if (options.binaryOutput)
+    {
+        // seqan does not know the extension, records are written by
+        // appendBinaryMatch() and header/footer of NO_COMMENTS are empty
+        globalHolder.outRawStream.open(options.output.c_str(), std::ios::binary | std::ios::out);
+        if (globalHolder.outRawStream.is_open())
+            success = open(globalHolder.outfile, globalHolder.outRawStream, typename TGH::TFormat());
+    }
+    else
+    {
+        success = open(globalHolder.outfile, toCString(options.output));
+    }
+
+    if (!success)
+    {
+        std::cerr << "\nCould not open the output file " << options.output
+                  << ", make sure the directory exists and is writable.\n";
+        return -1;
+    }
+
+    if (options.binaryOutput)
+    {
+        std::string header;
+        writeBinaryHeader(header, p, options.binaryCigar, options.queryFile, options.dbFile);
+        write(globalHolder.outfile.iter, header);
+    }
+    return 0;
+}
+
 /// THREAD LOCAL STUFF
 
 // --------------------------------------------------------------------------
@@ -562,6 +790,30 @@ generateSeeds(TLocalHolder & lH)
     }
 
     double start = sysTime();
+
+    uint64_t nSeeds = 0;
+    for (unsigned long i = lH.indexBeginQry; i < lH.indexEndQry; ++i)
+        if (length(value(lH.gH.redQrySeqs, i)) >= lH.options.seedLength)
+            nSeeds += (length(value(lH.gH.redQrySeqs, i)) - lH.options.seedLength) / lH.options.seedOffset + 1;
+    reserve(lH.seeds, nSeeds, Exact());
+    lH.seedRefs.reserve(nSeeds);
+    lH.seedRanks.reserve(nSeeds);
+
+    // for the query index and the seed cache the seeds are also packed into
+    // numbers of base ValueSize<TRedAlph>, whose order is the lexicographical
+    // order of the seeds (see generateTrieOverSeeds()); this works if
+    // sigma^seedLength fits into 64bit, e.g. for Murphy10 up to a seed length
+    // of 19
+    using TRedAlph = typename TLocalHolder::TGlobalHolder::TRedAlph;
+    uint64_t const sigma = ValueSize<TRedAlph>::VALUE;
+    uint64_t topPow = 1; // sigma^(seedLength - 1)
+    bool packed = lH.options.doubleIndexing || (lH.options.seedCacheSize > 0);
+    for (unsigned k = 1; packed && (k < lH.options.seedLength); ++k)
+        topPow *= sigma;
+    packed = packed && (topPow <= std::numeric_limits<uint64_t>::max() / sigma);
+    if (packed)
+        lH.seedCodes.reserve(nSeeds);
+
     for (unsigned long i = lH.indexBeginQry; i < lH.indexEndQry; ++i)
     {
         for (unsigned j = 0;
@@ -572,13 +824,29 @@ generateSeeds(TLocalHolder & lH)
             appendValue(lH.seeds, infix(value(lH.gH.redQrySeqs, i),
                                      j* lH.options.seedOffset,
                                      j* lH.options.seedOffset
-                                     + lH.options.seedLength),
-                        Generous());
-            appendValue(lH.seedRefs,  i, Generous());
-            appendValue(lH.seedRanks, j, Generous());
+                                     + lH.options.seedLength));
+            lH.seedRefs.push_back(i);
+            lH.seedRanks.push_back(j);
 
 //             std::cout << "seed: " << back(lH.seeds) << "\n";
         }
+
+        if (!packed)
+            continue;
+
+        // rolling code of the window that ends at p
+        auto const & seq = value(lH.gH.redQrySeqs, i);
+        uint64_t code = 0;
+        for (uint64_t p = 0; p < length(seq); ++p)
+        {
+            if (p >= lH.options.seedLength)
+                code -= ordValue(TRedAlph(seq[p - lH.options.seedLength])) * topPow;
+            code = code * sigma + ordValue(TRedAlph(seq[p]));
+
+            if ((p + 1 >= lH.options.seedLength) &&
+                ((p + 1 - lH.options.seedLength) % lH.options.seedOffset == 0))
+                lH.seedCodes.push_back(code);
+        }
     }
     double finish = sysTime() - start;
     if (lH.options.doubleIndexing)
@@ -597,6 +865,43 @@ generateSeeds(TLocalHolder & lH)
 // Function generateTrieOverSeeds()
 // --------------------------------------------------------------------------
 
+// orders the SA of the query index by the packed seeds of generateSeeds(),
+// with a radix sort on the bytes of the codes (least significant first)
+template <typename TSa>
+inline void
+_sortPackedSeeds(TSa & sa, std::vector<uint64_t> const & codes)
+{
+    uint64_t const n = codes.size();
+    std::vector<std::pair<uint64_t, uint64_t>> keys(n); // code, seed
+    std::vector<std::pair<uint64_t, uint64_t>> buf(n);
+    uint64_t maxCode = 0;
+    for (uint64_t u = 0; u < n; ++u)
+    {
+        keys[u] = std::make_pair(codes[u], u);
+        maxCode = std::max(maxCode, codes[u]);
+    }
+
+    for (unsigned shift = 0; (shift < 64) && ((maxCode >> shift) != 0); shift += 8)
+    {
+        std::array<uint64_t, 257> counts{};
+        for (auto const & k : keys)
+            ++counts[((k.first >> shift) & 0xff) + 1];
+        // all codes have the same digit, nothing to do
+        if (std::find(counts.begin(), counts.end(), n) != counts.end())
+            continue;
+        for (unsigned d = 1; d < counts.size(); ++d)
+            counts[d] += counts[d - 1];
+        for (auto const & k : keys)
+            buf[counts[(k.first >> shift) & 0xff]++] = k;
+        std::swap(keys, buf);
+    }
+
+    for (uint64_t u = 0; u < n; ++u)
+    {
+        assignValueI1(value(sa, u), keys[u].second);
+        assignValueI2(value(sa, u), 0);
+    }
+}
 
 template <typename TLocalHolder>
 inline int
@@ -616,13 +921,19 @@ generateTrieOverSeeds(TLocalHolder & lH)
     lH.seedIndex = decltype(lH.seedIndex)(lH.seeds);
     TSa & sa = indexSA(lH.seedIndex);
     resize(sa, length(lH.seeds));
-    for (unsigned u = 0; u < length(lH.seeds); ++u)
+    if (length(lH.seedCodes) == length(lH.seeds))
+    {
+        _sortPackedSeeds(sa, lH.seedCodes);
+    } else
     {
-        assignValueI1(value(sa,u), u);
-        assignValueI2(value(sa,u), 0);
+        for (unsigned u = 0; u < length(lH.seeds); ++u)
+        {
+            assignValueI1(value(sa,u), u);
+            assignValueI2(value(sa,u), 0);
+        }
+        Comp<typename Value<TSa>::Type, typename TLocalHolder::TSeeds const> comp(lH.seeds);
+        std::sort(begin(sa, Standard()), end(sa, Standard()), comp);
     }
-    Comp<typename Value<TSa>::Type, typename TLocalHolder::TSeeds const> comp(lH.seeds);
-    std::sort(begin(sa, Standard()), end(sa, Standard()), comp);
     typename Iterator<typename TLocalHolder::TSeedIndex, TopDown<> >::Type it(lH.seedIndex); // instantiate
     double finish = sysTime() - start;
 
@@ -678,7 +989,6 @@ template <typename BackSpec, typename TLocalHolder>
 inline void
 __searchSingleIndex(TLocalHolder & lH)
 {
-    typedef typename Iterator<decltype(lH.seeds) const, Rooted>::Type TSeedsIt;
     typedef typename Iterator<decltype(lH.gH.dbIndex),TopDown<>>::Type TIndexIt;
 
 //     SEQAN_OMP_PRAGMA(critical(stdout))
@@ -688,15 +998,187 @@ __searchSingleIndex(TLocalHolder & lH)
 //             std::cout << "\"" << toCString(CharString(seed)) << "\" ";
 //         std::cout << std::endl;
 //     }
-    auto delegate = [&lH] (TIndexIt & indexIt,
-                           TSeedsIt const & seedsIt,
-                           int /*score*/)
+    SeedIntervalCache & cache = lH.seedCache;
+    bool const cached = (cache.capacity > 0) && (length(lH.seedCodes) == length(lH.seeds));
+
+    for (uint64_t seedId = 0; seedId < length(lH.seeds); ++seedId)
     {
-        onFindSingleIndex(lH, seedsIt, indexIt);
-    };
+        if (cached)
+        {
+            ++lH.stats.seedCacheLookups;
+            auto const entry = cache.seeds.find(lH.seedCodes[seedId]);
+            if (entry != cache.seeds.end())
+            {
+                ++lH.stats.seedCacheHits;
+                for (uint64_t k = entry->second.first; k < entry->second.first + entry->second.second; ++k)
+                    onFindSingleIndex(lH, seedId, infix(indexSA(lH.gH.dbIndex),
+                                                        cache.intervals[k].first,
+                                                        cache.intervals[k].second));
+                continue;
+            }
+
+            if (cache.seeds.size() >= cache.capacity)
+            {
+                cache.seeds.clear();
+                cache.intervals.clear();
+            }
+        }
+
+        uint64_t const firstInterval = cache.intervals.size();
+        auto delegate = [&lH, &cache, cached, seedId] (TIndexIt const & indexIt, int /*score*/)
+        {
+            auto const subjOccs = getOccurrences(indexIt);
+            if (cached)
+                cache.intervals.emplace_back(beginPosition(subjOccs), endPosition(subjOccs));
+            onFindSingleIndex(lH, seedId, subjOccs);
+        };
+
+        find(lH.gH.dbIndex, lH.seeds[seedId], int(lH.options.maxSeedDist), delegate,
+             Backtracking<BackSpec>());
+
+        if (cached)
+            cache.seeds.emplace(lH.seedCodes[seedId],
+                                std::make_pair(firstInterval, cache.intervals.size() - firstInterval));
+    }
+}
+
+// the subject window of a hit of pigeonholeFind()
+template <typename TLocalHolder, typename TSAValue>
+inline auto
+_pigeonholeWindow(TLocalHolder const & lH, TSAValue const & occ)
+    -> decltype(infix(lH.gH.redSubjSeqs[0], 0, 0))
+{
+    uint64_t const subjLen = length(lH.gH.redSubjSeqs[getSeqNo(occ)]);
+    uint64_t const b = TLocalHolder::TGlobalHolder::indexIsFM
+                        ? subjLen - getSeqOffset(occ) - lH.options.seedLength
+                        : getSeqOffset(occ);
+    return infix(lH.gH.redSubjSeqs[getSeqNo(occ)], b, b + lH.options.seedLength);
+}
+
+// the hits of a seed with pigeonholeFind(); onFind(subjOccs) is called for
+// each group of hits with the same subject window, so that the delegates get
+// the same occurrences as from the backtracking
+template <typename TLocalHolder, typename TOnFind>
+inline void
+_pigeonholeSeed(TLocalHolder & lH, uint64_t const seedId, TOnFind && onFind)
+{
+    using TSAValue = typename Value<decltype(lH.seedOccs)>::Type;
+
+    clear(lH.seedOccs);
+    pigeonholeFind(lH.seedOccs, lH.gH.dbIndex, lH.gH.redSubjSeqs, lH.seeds[seedId], lH.options.maxSeedDist,
+                   TLocalHolder::TGlobalHolder::indexIsFM);
+    std::sort(begin(lH.seedOccs, Standard()), end(lH.seedOccs, Standard()),
+              [&lH] (TSAValue const & l, TSAValue const & r)
+    {
+        return _pigeonholeWindow(lH, l) < _pigeonholeWindow(lH, r);
+    });
+
+    for (uint64_t b = 0, e = 1; b < length(lH.seedOccs); b = e++)
+    {
+        while ((e < length(lH.seedOccs)) &&
+               (_pigeonholeWindow(lH, lH.seedOccs[b]) == _pigeonholeWindow(lH, lH.seedOccs[e])))
+            ++e;
+        onFind(infix(lH.seedOccs, b, e));
+    }
+}
+
+template <typename TLocalHolder>
+inline void
+__searchPigeonhole(TLocalHolder & lH)
+{
+    using TSubjOccs = typename Infix<decltype(lH.seedOccs)>::Type;
+
+    if (lH.options.doubleIndexing)
+    {
+        appendToStatus(lH.statusStr, lH.options, 1, "Seeding...");
+        if (lH.options.isTerm)
+            myPrint(lH.options, 1, lH.statusStr);
+    }
+
+    double start = sysTime();
 
-    find(lH.gH.dbIndex, lH.seeds, int(lH.options.maxSeedDist), delegate,
-         Backtracking<BackSpec>());
+    if (lH.options.doubleIndexing)
+    {
+        // identical seeds are neighbours in the SA of the query index, they
+        // are searched once
+        auto & sa = indexSA(lH.seedIndex);
+        for (uint64_t b = 0, e = 1; b < length(sa); b = e++)
+        {
+            while ((e < length(sa)) && (lH.seeds[getSeqNo(sa[b])] == lH.seeds[getSeqNo(sa[e])]))
+                ++e;
+            auto const qryOccs = infix(sa, b, e);
+            _pigeonholeSeed(lH, getSeqNo(sa[b]), [&lH, &qryOccs] (TSubjOccs const & subjOccs)
+            {
+                onFindDoubleIndex(lH, qryOccs, subjOccs);
+            });
+        }
+
+        double finish = sysTime() - start;
+        appendToStatus(lH.statusStr, lH.options, 1, " done. ");
+        appendToStatus(lH.statusStr, lH.options, 2, finish, "s. #hits: ",
+                       length(lH.matches), " ");
+        myPrint(lH.options, 1, lH.statusStr);
+    } else
+    {
+        for (uint64_t seedId = 0; seedId < length(lH.seeds); ++seedId)
+        {
+            _pigeonholeSeed(lH, seedId, [&lH, seedId] (TSubjOccs const & subjOccs)
+            {
+                onFindSingleIndex(lH, seedId, subjOccs);
+            });
+        }
+    }
+}
+
+template <typename TLocalHolder>
+inline void
+__searchKmer(TLocalHolder & lH)
+{
+    using TSubjOccs = typename Infix<typename Fibre<typename TLocalHolder::TGlobalHolder::TDbIndex,
+                                                    FibreSA>::Type const>::Type;
+
+    if (lH.options.doubleIndexing)
+    {
+        appendToStatus(lH.statusStr, lH.options, 1, "Seeding...");
+        if (lH.options.isTerm)
+            myPrint(lH.options, 1, lH.statusStr);
+    }
+
+    double start = sysTime();
+
+    if (lH.options.doubleIndexing)
+    {
+        // identical seeds are neighbours in the SA of the query index, they
+        // are searched once
+        auto & sa = indexSA(lH.seedIndex);
+        for (uint64_t b = 0, e = 1; b < length(sa); b = e++)
+        {
+            while ((e < length(sa)) && (lH.seeds[getSeqNo(sa[b])] == lH.seeds[getSeqNo(sa[e])]))
+                ++e;
+            auto const qryOccs = infix(sa, b, e);
+            kmerFind(lH.gH.dbIndex, lH.seeds[getSeqNo(sa[b])], lH.options.maxSeedDist,
+                     [&lH, &qryOccs] (TSubjOccs const & subjOccs)
+            {
+                onFindDoubleIndex(lH, qryOccs, subjOccs);
+            });
+        }
+
+        double finish = sysTime() - start;
+        appendToStatus(lH.statusStr, lH.options, 1, " done. ");
+        appendToStatus(lH.statusStr, lH.options, 2, finish, "s. #hits: ",
+                       length(lH.matches), " ");
+        myPrint(lH.options, 1, lH.statusStr);
+    } else
+    {
+        for (uint64_t seedId = 0; seedId < length(lH.seeds); ++seedId)
+        {
+            kmerFind(lH.gH.dbIndex, lH.seeds[seedId], lH.options.maxSeedDist,
+                     [&lH, seedId] (TSubjOccs const & subjOccs)
+            {
+                onFindSingleIndex(lH, seedId, subjOccs);
+            });
+        }
+    }
 }
 
 template <typename BackSpec, typename TLocalHolder>
@@ -709,12 +1191,24 @@ __search(TLocalHolder & lH)
         __searchSingleIndex<BackSpec>(lH);
 }
 
+// the k-mer index has no tree to backtrack in
 template <typename TLocalHolder>
 inline void
-search(TLocalHolder & lH)
+search(TLocalHolder & lH, std::true_type const & /*indexIsKmer*/)
+{
+    if (lH.options.hammingOnly)
+        __searchKmer(lH);
+}
+
+template <typename TLocalHolder>
+inline void
+search(TLocalHolder & lH, std::false_type const & /*indexIsKmer*/)
 {
     if (lH.options.maxSeedDist == 0)
         __search<Backtracking<Exact>>(lH);
+    else if (lH.options.hammingOnly && lH.options.pigeonhole &&
+             (lH.options.maxSeedDist < lH.options.seedLength))
+        __searchPigeonhole(lH);
     else if (lH.options.hammingOnly)
         __search<Backtracking<HammingDistance>>(lH);
     else
@@ -725,6 +1219,13 @@ search(TLocalHolder & lH)
 #endif
 }
 
+template <typename TLocalHolder>
+inline void
+search(TLocalHolder & lH)
+{
+    search(lH, std::integral_constant<bool, TLocalHolder::TGlobalHolder::indexIsKmer>());
+}
+
 // --------------------------------------------------------------------------
 // Function joinAndFilterMatches()
 // --------------------------------------------------------------------------
@@ -769,15 +1270,108 @@ sortMatches(TLocalHolder & lH)
     }
 }
 
+// the score part of computeAlignmentStats(); the score reported is that of the
+// final alignment rows, which can differ slightly from the extension's sum
+template <typename TGaps0, typename TGaps1, typename TScoreScheme>
+inline int
+_alignmentScore(TGaps0 const & row0, TGaps1 const & row1, TScoreScheme const & scheme)
+{
+    using TAlph = typename Value<typename Source<TGaps0>::Type>::Type;
+
+    int scr = 0;
+    bool gapOpen0 = false;
+    bool gapOpen1 = false;
+    auto it1 = begin(row1);
+    for (auto it0 = begin(row0), itEnd0 = end(row0); it0 != itEnd0; ++it0, ++it1)
+    {
+        bool const gap0 = isGap(it0);
+        bool const gap1 = isGap(it1);
+        if (gap0)
+            scr += gapOpen0 ? scoreGapExtend(scheme) : scoreGapOpen(scheme);
+        if (gap1)
+            scr += gapOpen1 ? scoreGapExtend(scheme) : scoreGapOpen(scheme);
+        if (!gap0 && !gap1)
+            scr += score(scheme, TAlph(*it0), static_cast<TAlph>(*it1));
+        gapOpen0 = gap0;
+        gapOpen1 = gap1;
+    }
+    return scr;
+}
+
+// extend the seed of *it by the following seeds on the same diagonal, with
+// markMerged these are not processed on their own any more
 template <typename TBlastMatch,
+          typename TIt,
           typename TLocalHolder>
-inline int
-computeBlastMatch(TBlastMatch         & bm,
-                  Match         const & m,
-                  TLocalHolder        & lH)
+inline void
+_mergeSiblings(TBlastMatch        & bm,
+               TIt          const & it,
+               TIt          const & itEnd,
+               bool         const   markMerged,
+               TLocalHolder       & lH)
 {
-    const unsigned long qryLength = length(value(lH.gH.qrySeqs, m.qryId));
+    using TPos = decltype(bm.qEnd);
+    auto const trueQryId  = it->qryId / qNumFrames(lH.gH.blastProgram);
+    auto const trueSubjId = it->subjId / sNumFrames(lH.gH.blastProgram);
+
+    for (auto it2 = std::next(it, 1);
+         (it2 != itEnd) &&
+         (trueQryId == it2->qryId / qNumFrames(lH.gH.blastProgram)) &&
+         (trueSubjId == it2->subjId / sNumFrames(lH.gH.blastProgram));
+        ++it2)
+    {
+        // same frame
+        if ((it->qryId % qNumFrames(lH.gH.blastProgram) == it2->qryId % qNumFrames(lH.gH.blastProgram)) &&
+            (it->subjId % sNumFrames(lH.gH.blastProgram) == it2->subjId % sNumFrames(lH.gH.blastProgram)))
+        {
+
+//             TPos const qDist = (it2->qryStart >= bm.qEnd)
+//                                 ? it2->qryStart - bm.qEnd // upstream
+//                                 : 0; // overlap
+// 
+//             TPos sDist = TPosMax; // subj match region downstream of *it
+//             if (it2->subjStart >= bm.sEnd) // upstream
+//                 sDist = it2->subjStart - bm.sEnd;
+//             else if (it2->subjStart >= it->subjStart) // overlap
+//                 sDist = 0;
+
+            // due to sorting it2->qryStart never <= it->qStart
+            // so subject sequences must have same order
+            if (it2->subjStart < it->subjStart)
+                continue;
+
+            long const qDist = it2->qryStart - bm.qEnd;
+            long const sDist = it2->subjStart - bm.sEnd;
+
+            if ((qDist == sDist) &&
+                (qDist <= (long)lH.options.seedGravity))
+            {
+                bm.qEnd = std::max(bm.qEnd,
+                                   (TPos)(it2->qryStart
+                                   + lH.options.seedLength));
+                bm.sEnd = std::max(bm.sEnd,
+                                   (TPos)(it2->subjStart
+                                   + lH.options.seedLength));
+                if (markMerged)
+                {
+                    ++lH.stats.hitsMerged;
+                    setToSkip(*it2);
+                }
+            }
+        }
+    }
+}
 
+// align the merged seeds; bm only needs the rows and the positions, so this
+// also works on the ExtensionCenter of _extensionScore()
+template <typename TBlastMatch,
+          typename TLocalHolder>
+inline int
+_alignCenter(int                 & scr,
+             TBlastMatch         & bm,
+             Match         const & m,
+             TLocalHolder        & lH)
+{
     SEQAN_ASSERT_LEQ(bm.qStart, bm.qEnd);
     SEQAN_ASSERT_LEQ(bm.sStart, bm.sEnd);
 
@@ -802,7 +1396,7 @@ computeBlastMatch(TBlastMatch         & bm,
 //     std::cout << "   " <<  bm.qStart << " - " << bm.qEnd << " [before ali]\n";
 //     std::cout << bm.align << std::endl;
 
-    int scr = 0;
+    scr = 0;
 
 //     unsigned short seedLeng = 0;
 //     double         seedE = 0;
@@ -835,39 +1429,17 @@ computeBlastMatch(TBlastMatch         & bm,
     if (maxDist == 0)
     {
         int scores[row0len+1]; // C99, C++14, -Wno-vla before that
-        scores[0] = 0;
-        unsigned newEnd = 0;
-        unsigned newBeg = 0;
-        // score the diagonal
-        for (unsigned i = 0; i < row0len; ++i)
-        {
-            scores[i] += score(seqanScheme(context(lH.gH.outfile).scoringScheme),
-                               source(bm.alignRow0)[i],
-                               source(bm.alignRow1)[i]);
-            if (scores[i] < 0)
-            {
-                scores[i] = 0;
-            } else if (scores[i] >= scr)
-            {
-                scr = scores[i];
-                newEnd = i + 1;
-            }
-//             if (i <row0len -1)
-            scores[i+1] = scores[i];
-        }
-        if (newEnd == 0) // no local alignment
+        UngappedAlignment const ali = ungappedAlignment(profileRows(queryProfile(lH, m.qryId), m.qryId, bm.qStart),
+                                                        source(bm.alignRow1),
+                                                        row0len,
+                                                        scores);
+        if (ali.endPos == 0) // no local alignment
         {
             return OTHER_FAIL; // TODO change to PREEXTEND?
         }
-        // backtrack
-        for (unsigned i = newEnd - 1; i > 0; --i)
-        {
-            if (scores[i] == 0)
-            {
-                newBeg = i + 1;
-                break;
-            }
-        }
+        scr = ali.score;
+        unsigned const newEnd = ali.endPos;
+        unsigned const newBeg = ali.beginPos;
         setEndPosition(bm.alignRow0, newEnd);
         setEndPosition(bm.alignRow1, newEnd);
         setBeginPosition(bm.alignRow0, newBeg);
@@ -892,6 +1464,271 @@ computeBlastMatch(TBlastMatch         & bm,
     bm.sEnd   =  bm.sStart + endPosition(bm.alignRow1);
     bm.sStart += beginPosition(bm.alignRow1);
 
+    return 0;
+}
+
+// whether the aligned center has to be extended at all
+template <typename TBlastMatch,
+          typename TLocalHolder>
+inline bool
+_needsExtension(TBlastMatch const & bm, Match const & m, TLocalHolder const & lH)
+{
+    return ((bm.qStart > 0) && (bm.sStart > 0)) ||
+           ((bm.qEnd < length(lH.gH.qrySeqs[m.qryId]) - 1) && (bm.sEnd < length(lH.gH.subjSeqs[m.subjId]) -1));
+}
+
+// we want to allow more gaps in longer query sequences
+template <typename TLocalHolder>
+inline unsigned short
+_extensionBand(unsigned long const qryLength, TLocalHolder const & lH)
+{
+    switch (lH.options.band)
+    {
+        case -3: return ceil(log2(qryLength));
+        case -2: return floor(sqrt(qryLength));
+        case -1: return 0; // not banded
+        default: return lH.options.band;
+    }
+}
+
+// the score of the final rows can be higher than the sum of the parts, when
+// a gap continues across the border of the center
+template <typename TLocalHolder>
+inline int
+_gapSlack(TLocalHolder const & lH)
+{
+    return 2 * (scoreGapExtend(seqanScheme(context(lH.gH.outfile).scoringScheme)) -
+                scoreGapOpen(seqanScheme(context(lH.gH.outfile).scoringScheme)));
+}
+
+// no extension can align more characters than the shorter of the remaining
+// query and subject on either side of the center, so this is an upper bound
+// of the extended score
+template <typename TBlastMatch,
+          typename TLocalHolder>
+inline int64_t
+_extensionScoreBound(TBlastMatch const & bm, int const scr, Match const & m, TLocalHolder const & lH)
+{
+    uint64_t const overlap = std::min<uint64_t>(bm.qStart, bm.sStart) +
+                             std::min<uint64_t>(length(lH.gH.qrySeqs[m.qryId]) - bm.qEnd,
+                                                length(lH.gH.subjSeqs[m.subjId]) - bm.sEnd);
+    return int64_t(scr) + int64_t(std::max(0, lH.gH.ungappedTable.maxScore)) * overlap +
+           std::max(0, _gapSlack(lH));
+}
+
+// add the extensions of an aligned center to lH.extBatch, with the same
+// conditions as seqan's _extendAlignmentImpl(); center is the slot of the
+// center in lH.extCenters or -1
+template <typename TBlastMatch,
+          typename TLocalHolder>
+inline void
+_appendExtensionCandidate(TBlastMatch const & bm, Match const & m, int const center, TLocalHolder & lH)
+{
+    QueryProfile const & profile = queryProfile(lH, m.qryId);
+    auto const & hSeq = lH.gH.qrySeqs[m.qryId];
+    auto const & vSeq = lH.gH.subjSeqs[m.subjId];
+
+    ExtensionCandidate c { &m, bm.qStart, bm.sStart, bm.qEnd, bm.sEnd, -1, -1, 0, center };
+    if ((bm.qStart > 0) && (bm.sStart > 0))
+    {
+        auto vInf = infix(vSeq, 0, bm.sStart);
+        ModifiedString<decltype(vInf), ModReverse> const vRev(vInf);
+        c.left = appendExtension(lH.extBatch, profileRows(profile, m.qryId, bm.qStart, true), bm.qStart,
+                                 begin(vRev, Standard()), bm.sStart);
+    }
+    if ((bm.qEnd < length(hSeq)) && (bm.sEnd < length(vSeq)))
+    {
+        c.right = appendExtension(lH.extBatch, profileRows(profile, m.qryId, bm.qEnd), length(hSeq) - bm.qEnd,
+                                  begin(vSeq, Standard()) + bm.sEnd, length(vSeq) - bm.sEnd);
+    }
+    lH.extCandidates.push_back(c);
+}
+
+// the first slot of lH.extCenters that no candidate uses
+template <typename TLocalHolder>
+inline unsigned
+_freeCenterSlot(TLocalHolder & lH)
+{
+    unsigned slot = 0;
+    while (std::any_of(lH.extCandidates.begin(), lH.extCandidates.end(),
+                       [slot] (ExtensionCandidate const & c) { return c.center == int(slot); }))
+        ++slot;
+    if (lH.extCenters.size() <= slot)
+        lH.extCenters.resize(slot + 1);
+    return slot;
+}
+
+// dest = src, except that dest keeps its own copy of the source infix;
+// Gaps::operator=() would make it depend on the one of src
+template <typename TGaps>
+inline void
+_assignAlignRow(TGaps & dest, TGaps const & src)
+{
+    assignSource(dest, source(src));
+    dest._array             = src._array;
+    dest._sourceBeginPos    = src._sourceBeginPos;
+    dest._sourceEndPos      = src._sourceEndPos;
+    dest._clippingBeginPos  = src._clippingBeginPos;
+    dest._clippingEndPos    = src._clippingEndPos;
+}
+
+// the center of m, if the look-ahead of _extensionScore() has aligned it; bm
+// holds the merged seeds
+template <typename TBlastMatch,
+          typename TLocalHolder>
+inline typename TLocalHolder::TExtensionCenter const *
+_alignedCenter(TBlastMatch const & bm, Match const & m, TLocalHolder const & lH)
+{
+    for (ExtensionCandidate const & c : lH.extCandidates)
+    {
+        if ((c.match != &m) || (c.center < 0))
+            continue;
+        auto const & center = lH.extCenters[c.center];
+        if ((center.seedQEnd == bm.qEnd) && (center.seedSEnd == bm.sEnd))
+            return &center;
+    }
+    return nullptr;
+}
+
+// score of the gapped extension of the center in both directions, without
+// traceback; the following matches of the query are scored in the same batch
+// (the center of a match only depends on the seeds, see iterateMatches())
+// and their centers are kept for computeBlastMatch(). Left out are matches
+// that fail the score bound, and further matches on the subject frame of the
+// previous candidate, which would often be dropped as putative duplicates.
+template <typename TBlastMatch,
+          typename TIt,
+          typename TLocalHolder>
+inline int
+_extensionScore(TBlastMatch          const & bm,
+                TIt                  const & it,
+                TIt                  const & itEnd,
+                unsigned short       const   maxDist,
+                TLocalHolder               & lH)
+{
+    auto const & scheme = seqanScheme(context(lH.gH.outfile).scoringScheme);
+    ExtensionParams const params { scoreGapOpen(scheme), scoreGapExtend(scheme),
+                                   lH.options.band != -1, -maxDist, +maxDist,
+                                   lH.options.xDropOff != -1, lH.options.xDropOff };
+
+    QueryProfile const & profile = queryProfile(lH, it->qryId);
+    auto const & hSeq = lH.gH.qrySeqs[it->qryId];
+    auto const & vSeq = lH.gH.subjSeqs[it->subjId];
+
+    if (!params.banded)
+    {
+        int ret = 0;
+        if ((bm.qStart > 0) && (bm.sStart > 0))
+        {
+            auto vInf = infix(vSeq, 0, bm.sStart);
+            ModifiedString<decltype(vInf), ModReverse> const vRev(vInf);
+            ret += extensionScore(profileRows(profile, it->qryId, bm.qStart, true), bm.qStart,
+                                  begin(vRev, Standard()), bm.sStart, params, lH.extScratch);
+        }
+        if ((bm.qEnd < length(hSeq)) && (bm.sEnd < length(vSeq)))
+        {
+            ret += extensionScore(profileRows(profile, it->qryId, bm.qEnd), length(hSeq) - bm.qEnd,
+                                  begin(vSeq, Standard()) + bm.sEnd, length(vSeq) - bm.sEnd,
+                                  params, lH.extScratch);
+        }
+        return ret;
+    }
+
+    for (ExtensionCandidate const & c : lH.extCandidates)
+        if ((c.match == &*it) && (c.qStart == bm.qStart) && (c.sStart == bm.sStart) &&
+            (c.qEnd == bm.qEnd) && (c.sEnd == bm.sEnd))
+            return c.score;
+
+    // candidates before this match have been processed, those behind it are
+    // scored already and are kept
+    lH.extCandidates.erase(std::remove_if(lH.extCandidates.begin(), lH.extCandidates.end(),
+                                          [&it] (ExtensionCandidate const & c) { return c.match < &*it; }),
+                           lH.extCandidates.end());
+    Match const * last = &*it;
+    for (ExtensionCandidate const & c : lH.extCandidates)
+        last = std::max(last, c.match);
+
+    // new batch with this match and the next ones that need an extension
+    // with the same band (all frames of the query are in one profile)
+    clear(lH.extBatch, params, &profile.scores[0]);
+    _appendExtensionCandidate(bm, *it, -1, lH);
+
+    auto const trueQryId = it->qryId / qNumFrames(lH.gH.blastProgram);
+    int const minRawScore = lH.gH.minRawScores[_eValueQryLength(bm.qLength, lH.gH.blastProgram)];
+    for (auto it2 = std::next(it, last - &*it + 1);
+         (it2 != itEnd) &&
+         (trueQryId == it2->qryId / qNumFrames(lH.gH.blastProgram)) &&
+         (lH.extBatch.problems.size() < extensionLanes());
+         ++it2)
+    {
+        if (isSetToSkip(*it2) ||
+            (lH.options.filterPutativeDuplicates && (it2->qryId == last->qryId) && (it2->subjId == last->subjId)) ||
+            (_extensionBand(length(lH.gH.qrySeqs[it2->qryId]), lH) != maxDist))
+            continue;
+
+        unsigned const slot = _freeCenterSlot(lH);
+        auto & center = lH.extCenters[slot];
+        center.qStart = it2->qryStart;
+        center.qEnd   = it2->qryStart + lH.options.seedLength;
+        center.sStart = it2->subjStart;
+        center.sEnd   = it2->subjStart + lH.options.seedLength;
+        _mergeSiblings(center, it2, itEnd, false, lH);
+        center.seedQEnd = center.qEnd;
+        center.seedSEnd = center.sEnd;
+
+        if ((_alignCenter(center.score, center, *it2, lH) == 0) &&
+            _needsExtension(center, *it2, lH) &&
+            (_extensionScoreBound(center, center.score, *it2, lH) >= minRawScore))
+        {
+            _appendExtensionCandidate(center, *it2, slot, lH);
+            last = &*it2;
+        }
+    }
+
+    scoreExtensions(lH.extBatch);
+    int ret = 0;
+    for (ExtensionCandidate & c : lH.extCandidates)
+    {
+        if ((c.left < 0) && (c.right < 0))
+            continue;
+        c.score = ((c.left  >= 0) ? lH.extBatch.problems[c.left].score  : 0) +
+                  ((c.right >= 0) ? lH.extBatch.problems[c.right].score : 0);
+        c.left  = -1;
+        c.right = -1;
+        if (c.match == &*it)
+            ret = c.score;
+    }
+    return ret;
+}
+
+template <typename TBlastMatch,
+          typename TIt,
+          typename TLocalHolder>
+inline int
+computeBlastMatch(TBlastMatch         & bm,
+                  TIt           const & it,
+                  TIt           const & itEnd,
+                  TLocalHolder        & lH)
+{
+    Match const & m = *it;
+    const unsigned long qryLength = length(value(lH.gH.qrySeqs, m.qryId));
+
+    int scr = 0;
+    if (auto const * center = _alignedCenter(bm, m, lH))
+    {
+        _assignAlignRow(bm.alignRow0, center->alignRow0);
+        _assignAlignRow(bm.alignRow1, center->alignRow1);
+        bm.qStart    = center->qStart;
+        bm.qEnd      = center->qEnd;
+        bm.sStart    = center->sStart;
+        bm.sEnd      = center->sEnd;
+        scr          = center->score;
+    }
+    else if (_alignCenter(scr, bm, m, lH) != 0)
+    {
+        return OTHER_FAIL;
+    }
+
 //     if (scr < lH.options.minSeedScore)
 //         return PREEXTEND;
 
@@ -983,16 +1820,25 @@ computeBlastMatch(TBlastMatch         & bm,
         bm.sEnd   =  endPosition(row1);
     }
 #endif
-    if (((bm.qStart > 0) && (bm.sStart > 0)) ||
-        ((bm.qEnd < qryLength - 1) && (bm.sEnd < length(lH.gH.subjSeqs[m.subjId]) -1)))
+    if (_needsExtension(bm, m, lH))
     {
-        // we want to allow more gaps in longer query sequences
-        switch (lH.options.band)
+        unsigned short const maxDist = _extensionBand(qryLength, lH);
+
+        int const gapSlack = _gapSlack(lH);
+        int const minRawScore = lH.gH.minRawScores[_eValueQryLength(bm.qLength, lH.gH.blastProgram)];
+
+        if (_extensionScoreBound(bm, scr, m, lH) < minRawScore)
+            return SCOREBOUND;
+
+        // score-only first, the traceback is only computed for matches that
+        // can still pass the e-value test; seqan uses a different DP for a
+        // band of width one which is not reproduced
+        if ((maxDist > 0) || (lH.options.band == -1))
         {
-            case -3: maxDist = ceil(log2(qryLength)); break;
-            case -2: maxDist = floor(sqrt(qryLength)); break;
-            case -1: break;
-            default: maxDist = lH.options.band; break;
+            int const bound = scr + _extensionScore(bm, it, itEnd, maxDist, lH) + std::max(0, gapSlack);
+
+            if (bound < minRawScore)
+                return EVALUE;
         }
 
         Tuple<decltype(bm.qStart), 4> positions =
@@ -1089,23 +1935,25 @@ computeBlastMatch(TBlastMatch         & bm,
 
 //     std::cout << "ALIGN BEFORE STATS:\n" << bm.align << "\n";
 
-    computeAlignmentStats(bm, context(lH.gH.outfile));
+    // the score of the final rows decides the e-value, the remaining
+    // statistics are only computed for matches that pass
+    bm.alignStats.alignmentScore = _alignmentScore(bm.alignRow0, bm.alignRow1,
+                                                   seqanScheme(context(lH.gH.outfile).scoringScheme));
 
-    if (bm.alignStats.alignmentIdentity < lH.options.idCutOff)
-        return PERCENTIDENT;
-
-//     const unsigned long qryLength = length(row0);
     computeBitScore(bm, context(lH.gH.outfile));
+    computeEValue(bm, lH.gH);
 
-    // the length adjustment cache must no be written to by multiple threads
-    SEQAN_OMP_PRAGMA(critical(evalue_length_adj_cache))
+    if (bm.eValue > lH.options.eCutOff)
     {
-        computeEValue(bm, context(lH.gH.outfile));
+        return EVALUE;
     }
 
-    if (bm.eValue > lH.options.eCutOff)
+    if (lH.options.computeAlignStats)
     {
-        return EVALUE;
+        computeAlignmentStats(bm, context(lH.gH.outfile));
+
+        if (bm.alignStats.alignmentIdentity < lH.options.idCutOff)
+            return PERCENTIDENT;
     }
 
     if (qIsTranslated(TLocalHolder::TGlobalHolder::blastProgram))
@@ -1141,22 +1989,44 @@ computeBlastMatch(TBlastMatch         & bm,
     return 0;
 }
 
+// hand the locally formatted records to the writer thread; for ordered output
+// the end of every block needs to be signalled, even if it had no records
+template <typename TLocalHolder>
+inline void
+flushOutput(TLocalHolder & lH, bool const blockDone = false)
+{
+    if ((lH.outChunk.nRecords == 0) && !(blockDone && lH.options.orderedOutput))
+        return;
+
+    lH.outChunk.blockId = lH.gH.blockOffset + lH.i;
+    lH.outChunk.blockDone = blockDone;
+    lH.gH.writer.push(lH.outChunk); // swaps in an empty chunk
+    lH.outChunk.buffer.clear();
+    lH.outChunk.nRecords = 0;
+}
+
+// format a record into the thread-local output buffer
+template <typename TLocalHolder, typename TBlastRecord>
+inline void
+formatRecord(TLocalHolder & lH, TBlastRecord const & record, BlastTabular const &)
+{
+    writeTabularRecord(lH.outChunk.buffer, lH.outContext, record, lH.gH.outColumnPlan);
+}
+
+template <typename TLocalHolder, typename TBlastRecord>
+inline void
+formatRecord(TLocalHolder & lH, TBlastRecord const & record, BlastReport const &)
+{
+    writeRecord(lH.outChunk.buffer, lH.outContext, record, BlastReport());
+}
+
 template <typename TLocalHolder>
 inline int
 iterateMatches(TLocalHolder & lH)
 {
     using TGlobalHolder = typename TLocalHolder::TGlobalHolder;
-    using TPos          = uint32_t; //typename Match::TPos;
-    using TBlastMatch   = BlastMatch<
-                           typename TLocalHolder::TAlignRow0,
-                           typename TLocalHolder::TAlignRow1,
-                           TPos,
-                           typename Value<typename TGlobalHolder::TQryIds>::Type,// const &,
-                           typename Value<typename TGlobalHolder::TSubjIds>::Type// const &,
-                           >;
-    using TBlastRecord  = BlastRecord<TBlastMatch>;
-
-//     constexpr TPos TPosMax = std::numeric_limits<TPos>::max();
+    using TBlastRecord  = typename TLocalHolder::TBlastRecord;
+
 //     constexpr uint8_t qFactor = qHasRevComp(lH.gH.blastProgram) ? 3 : 1;
 //     constexpr uint8_t sFactor = sHasRevComp(lH.gH.blastProgram) ? 3 : 1;
 
@@ -1187,11 +2057,14 @@ iterateMatches(TLocalHolder & lH)
         itN = std::next(it,1);
         auto const trueQryId = it->qryId / qNumFrames(lH.gH.blastProgram);
 
-        TBlastRecord record(lH.gH.qryIds[trueQryId]);
-
+        // the matches are collected in lH.recordMatches, the record is only
+        // filled for output
+        TBlastRecord & record = lH.outRecord;
+        record.qId = lH.gH.qryIds[trueQryId];
         record.qLength = (qIsTranslated(lH.gH.blastProgram)
                             ? lH.gH.untransQrySeqLengths[trueQryId]
                             : length(lH.gH.qrySeqs[it->qryId]));
+        auto & matches = lH.recordMatches;
 
 //         topMaxMatchesMedianBitScore = 0;
 
@@ -1207,43 +2080,40 @@ iterateMatches(TLocalHolder & lH)
             if (!isSetToSkip(*it))
             {
                 // ABUNDANCY and PUTATIVE ABUNDANCY CHECKS
-                if ((lH.options.filterPutativeAbundant) && (record.matches.size() % lH.options.maxMatches == 0))
+                if ((lH.options.filterPutativeAbundant) && (matches.order.size() % lH.options.maxMatches == 0))
                 {
-                    if (record.matches.size() / lH.options.maxMatches == 1)
+                    if (matches.order.size() / lH.options.maxMatches == 1)
                     {
                         // numMaxMatches found the first time
-                        record.matches.sort();
+                        sortBlastMatches(matches);
                     }
-                    else if (record.matches.size() / lH.options.maxMatches > 1)
+                    else if (matches.order.size() / lH.options.maxMatches > 1)
                     {
                         double medianTopNMatchesBefore = 0.0;
 //                         if (lH.options.filterPutativeAbundant)
                         {
                             medianTopNMatchesBefore =
-                            (std::next(record.matches.begin(),
-                                       lH.options.maxMatches / 2))->bitScore;
+                            blastMatch(matches, lH.options.maxMatches / 2).bitScore;
                         }
 
-                        uint64_t before = record.matches.size();
-                        record.matches.sort();
+                        uint64_t before = matches.order.size();
+                        sortBlastMatches(matches);
                         // if we filter putative duplicates we never need to check for real duplicates
                         if (!lH.options.filterPutativeDuplicates)
                         {
-                            record.matches.unique();
-                            lH.stats.hitsDuplicate += before - record.matches.size();
-                            before = record.matches.size();
+                            uniqueBlastMatches(matches);
+                            lH.stats.hitsDuplicate += before - matches.order.size();
+                            before = matches.order.size();
                         }
-                        if (record.matches.size() > (lH.options.maxMatches + 1))
-                            // +1 so as not to trigger % == 0 in the next run
-                            record.matches.resize(lH.options.maxMatches + 1);
+                        // +1 so as not to trigger % == 0 in the next run
+                        truncateBlastMatches(matches, lH.options.maxMatches + 1);
 
-                        lH.stats.hitsAbundant += before - record.matches.size();
+                        lH.stats.hitsAbundant += before - matches.order.size();
 
 //                         if (lH.options.filterPutativeAbundant)
                         {
                             double medianTopNMatchesAfter =
-                            (std::next(record.matches.begin(),
-                                       lH.options.maxMatches / 2))->bitScore;
+                            blastMatch(matches, lH.options.maxMatches / 2).bitScore;
                             // no new matches in top n/2
                             if (int(medianTopNMatchesAfter) <=
                                 int(medianTopNMatchesBefore))
@@ -1265,12 +2135,10 @@ iterateMatches(TLocalHolder & lH)
                     }
                 }
 //                 std::cout << "BAX\n" << std::flush;
-                // create blastmatch in list without copy or move
-                record.matches.emplace_back(lH.gH.qryIds [trueQryId],
-                                            lH.gH.subjIds[trueSubjId]);
-
-                auto & bm = back(record.matches);
+                // reuses a discarded blastmatch if possible
+                auto & bm = newBlastMatch(matches, lH.gH.qryIds[trueQryId], lH.gH.subjIds[trueSubjId]);
 
+                bm.subjIdx   = trueSubjId;
                 bm.qStart    = it->qryStart;
                 bm.qEnd      = it->qryStart + lH.options.seedLength;
                 bm.sStart    = it->subjStart;
@@ -1282,53 +2150,10 @@ iterateMatches(TLocalHolder & lH)
                                 : length(lH.gH.subjSeqs[it->subjId]);
 
                 // MERGE PUTATIVE SIBLINGS INTO THIS MATCH
-                for (auto it2 = itN;
-                     (it2 != itEnd) &&
-                     (trueQryId == it2->qryId / qNumFrames(lH.gH.blastProgram)) &&
-                     (trueSubjId == it2->subjId / sNumFrames(lH.gH.blastProgram));
-                    ++it2)
-                {
-                    // same frame
-                    if ((it->qryId % qNumFrames(lH.gH.blastProgram) == it2->qryId % qNumFrames(lH.gH.blastProgram)) &&
-                        (it->subjId % sNumFrames(lH.gH.blastProgram) == it2->subjId % sNumFrames(lH.gH.blastProgram)))
-                    {
-
-//                         TPos const qDist = (it2->qryStart >= bm.qEnd)
-//                                             ? it2->qryStart - bm.qEnd // upstream
-//                                             : 0; // overlap
-// 
-//                         TPos sDist = TPosMax; // subj match region downstream of *it
-//                         if (it2->subjStart >= bm.sEnd) // upstream
-//                             sDist = it2->subjStart - bm.sEnd;
-//                         else if (it2->subjStart >= it->subjStart) // overlap
-//                             sDist = 0;
-
-                        // due to sorting it2->qryStart never <= it->qStart
-                        // so subject sequences must have same order
-                        if (it2->subjStart < it->subjStart)
-                            continue;
-
-                        long const qDist = it2->qryStart - bm.qEnd;
-                        long const sDist = it2->subjStart - bm.sEnd;
-
-                        if ((qDist == sDist) &&
-                            (qDist <= (long)lH.options.seedGravity))
-                        {
-                            bm.qEnd = std::max(bm.qEnd,
-                                               (TPos)(it2->qryStart
-                                               + lH.options.seedLength));
-                            bm.sEnd = std::max(bm.sEnd,
-                                               (TPos)(it2->subjStart
-                                               + lH.options.seedLength));
-                            ++lH.stats.hitsMerged;
-
-                            setToSkip(*it2);
-                        }
-                    }
-                }
+                _mergeSiblings(bm, it, itEnd, true, lH);
 
                 // do the extension and statistics
-                int lret = computeBlastMatch(bm, *it, lH);
+                int lret = computeBlastMatch(bm, it, itEnd, lH);
 
                 switch (lret)
                 {
@@ -1344,6 +2169,9 @@ iterateMatches(TLocalHolder & lH)
                     case PREEXTEND:
                         ++lH.stats.hitsFailedPreExtendTest;
                         break;
+                    case SCOREBOUND:
+                        ++lH.stats.hitsFailedScoreBoundTest;
+                        break;
                     default:
                         std::cerr << "Unexpected Extension Failure:\n"
                           << "qryId: " << it->qryId << "\t"
@@ -1374,7 +2202,7 @@ iterateMatches(TLocalHolder & lH)
 
                 if (lret != 0)// discard match
                 {
-                    record.matches.pop_back();
+                    truncateBlastMatches(matches, matches.order.size() - 1);
                 } else if (lH.options.filterPutativeDuplicates)
                 {
                     // PUTATIVE DUBLICATES CHECK
@@ -1421,31 +2249,45 @@ iterateMatches(TLocalHolder & lH)
                 break;
         }
 
-        if (length(record.matches) > 0)
+        if (matches.order.size() > 0)
         {
             ++lH.stats.qrysWithHit;
-            // sort and remove duplicates -> STL, yeah!
-            auto const before = record.matches.size();
-            record.matches.sort();
+            // sort and remove duplicates
+            auto const before = matches.order.size();
+            sortBlastMatches(matches);
             if (!lH.options.filterPutativeDuplicates)
             {
-                record.matches.unique();
-                lH.stats.hitsDuplicate += before - record.matches.size();
+                uniqueBlastMatches(matches);
+                lH.stats.hitsDuplicate += before - matches.order.size();
             }
-            if (record.matches.size() > lH.options.maxMatches)
+            if (matches.order.size() > lH.options.maxMatches)
             {
-                lH.stats.hitsAbundant += record.matches.size() -
+                lH.stats.hitsAbundant += matches.order.size() -
                                          lH.options.maxMatches;
-                record.matches.resize(lH.options.maxMatches);
+                truncateBlastMatches(matches, lH.options.maxMatches);
             }
-            lH.stats.hitsFinal += record.matches.size();
+            lH.stats.hitsFinal += matches.order.size();
 
-            SEQAN_OMP_PRAGMA(critical(filewrite))
+            if (lH.options.binaryOutput)
             {
-                writeRecord(lH.gH.outfile, record);
+                for (uint64_t i = 0; i < matches.order.size(); ++i)
+                {
+                    auto const & bm = blastMatch(matches, i);
+                    appendBinaryMatch(lH.outChunk.buffer, bm, lH.gH.qryIdOffset + trueQryId, bm.subjIdx,
+                                      lH.options.binaryCigar);
+                }
+            }
+            else
+            {
+                makeOutputRecord(lH);
+                formatRecord(lH, record, typename TGlobalHolder::TFormat());
             }
+            ++lH.outChunk.nRecords;
+            // hand over in pieces to bound the size of the local buffer
+            if (length(lH.outChunk.buffer) >= (1ull << 20))
+                flushOutput(lH);
         }
-
+        truncateBlastMatches(matches, 0);
     }
 
     if (lH.options.doubleIndexing)
@@ -1477,6 +2319,10 @@ void printStats(StatsHolder const & stats, LambdaOptions const & options)
         std::cout << "Remaining\033[0m"
                   << "\n   after Seeding               "; BLANKS;
         std::cout << R << rem;
+        std::cout << "\n - frequent subject seeds   " << R << stats.hitsFrequentSubjSeed
+                  << RR << (rem -= stats.hitsFrequentSubjSeed);
+        std::cout << "\n - frequent query seeds     " << R << stats.hitsFrequentQrySeed
+                  << RR << (rem -= stats.hitsFrequentQrySeed);
         std::cout << "\n - masked                   " << R << stats.hitsMasked
                   << RR << (rem -= stats.hitsMasked);
         std::cout << "\n - merged                   " << R << stats.hitsMerged
@@ -1490,12 +2336,16 @@ void printStats(StatsHolder const & stats, LambdaOptions const & options)
         std::cout << "\n - failed pre-extend test   " << R
                   << stats.hitsFailedPreExtendTest  << RR
                   << (rem -= stats.hitsFailedPreExtendTest);
-        std::cout << "\n - failed %-identity test   " << R
-                  << stats.hitsFailedExtendPercentIdentTest << RR
-                  << (rem -= stats.hitsFailedExtendPercentIdentTest);
+        std::cout << "\n - failed score-bound test  " << R
+                  << stats.hitsFailedScoreBoundTest << RR
+                  << (rem -= stats.hitsFailedScoreBoundTest);
+        // the identity is only tested for hits that pass the e-value test
         std::cout << "\n - failed e-value test      " << R
                   << stats.hitsFailedExtendEValueTest << RR
                   << (rem -= stats.hitsFailedExtendEValueTest);
+        std::cout << "\n - failed %-identity test   " << R
+                  << stats.hitsFailedExtendPercentIdentTest << RR
+                  << (rem -= stats.hitsFailedExtendPercentIdentTest);
         std::cout << "\n - abundant                 " << R
                   << stats.hitsAbundant << RR
                   << (rem -= stats.hitsAbundant);
@@ -1506,6 +2356,11 @@ void printStats(StatsHolder const & stats, LambdaOptions const & options)
 
         if (rem != stats.hitsFinal)
             std::cout << "WARNING: hits dont add up\n";
+
+        if (stats.seedCacheLookups > 0)
+            std::cout << "Seed cache hits: " << stats.seedCacheHits << " of "
+                      << stats.seedCacheLookups << " seeds ("
+                      << 100.0 * stats.seedCacheHits / stats.seedCacheLookups << "%)\n\n";
     }
 
     if (options.verbosity >= 1)
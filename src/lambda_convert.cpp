@@ -0,0 +1,270 @@
+// ==========================================================================
+//                                  lambda
+// ==========================================================================
+// Copyright (c) 2013-2015, Hannes Hauswedell, FU Berlin
+// All rights reserved.
+//
+// This file is part of Lambda.
+//
+// Lambda is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Lambda is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with Lambda.  If not, see <http://www.gnu.org/licenses/>.*/
+// ==========================================================================
+// Author: Hannes Hauswedell <hannes.hauswedell @ fu-berlin.de>
+// ==========================================================================
+// lambda_convert.cpp: expands binary output (.m8b) to BLAST tabular
+// ==========================================================================
+
+#include <seqan/basic.h>
+
+#include <seqan/arg_parse.h>
+#include <seqan/seq_io.h>
+#include <seqan/blast.h>
+#include <seqan/reduced_aminoacid.h>
+
+#include <iostream>
+
+#include "options.hpp"
+#include "misc.hpp"
+#include "binary_output.hpp"
+
+using namespace seqan;
+
+// ==========================================================================
+// Functions
+// ==========================================================================
+
+// --------------------------------------------------------------------------
+// Function loadQryIds()
+// --------------------------------------------------------------------------
+
+template <typename TIds>
+inline int
+loadQryIds(TIds & ids, std::string const & path)
+{
+    SeqFileIn infile;
+    if (!open(infile, path.c_str()))
+    {
+        std::cerr << "\nCould not open the query file " << path << ", make sure it exists and is readable "
+                  << "(or pass its new location with -q).\n";
+        return -1;
+    }
+
+    CharString id;
+    CharString seq;
+    try
+    {
+        while (!atEnd(infile))
+        {
+            readRecord(id, seq, infile);
+            appendValue(ids, id, Generous());
+        }
+    }
+    catch(ParseError const & e)
+    {
+        std::cerr << "\nParseError thrown: " << e.what() << '\n'
+                  << "Make sure that the query file is in correct format.\n";
+        return -1;
+    }
+    catch(IOError const & e)
+    {
+        std::cerr << "\nIOError thrown: " << e.what() << '\n'
+                  << "Could not read the query file, make sure it exists and is readable.\n";
+        return -1;
+    }
+    return 0;
+}
+
+// --------------------------------------------------------------------------
+// Function convert()
+// --------------------------------------------------------------------------
+
+// writes one BlastRecord per run of matches with the same query
+
+template <typename TFile, typename TQryIds, typename TSubjIds, typename TMapped>
+inline int
+convert(TFile                & outfile,
+        BinaryHeader   const & h,
+        TMapped        const & file,
+        TQryIds        const & qryIds,
+        TSubjIds       const & subjIds)
+{
+    using TQId          = typename Infix<typename Concatenator<TQryIds const>::Type>::Type;
+    using TSId          = typename Infix<typename Concatenator<TSubjIds const>::Type>::Type;
+    using TAlignRow     = Gaps<CharString, ArrayGaps>;
+    using TBlastMatch   = BlastMatch<TAlignRow, TAlignRow, uint32_t, TQId, TSId>;
+    using TBlastRecord  = BlastRecord<TBlastMatch>;
+
+    char const * it     = begin(file, Standard()) + h.headerSize;
+    char const * itEnd  = end(file, Standard());
+
+    TBlastRecord record;
+    uint64_t curQry = MaxValue<uint64_t>::VALUE;
+
+    while (it < itEnd)
+    {
+        BinaryMatch m;
+        if (itEnd - it < (long)sizeof(m))
+        {
+            std::cerr << "\nThe input file is truncated.\n";
+            return -1;
+        }
+        std::memcpy(&m, it, sizeof(m));
+        it += sizeof(m);
+        if (h.hasCigar) // not needed for tabular output
+            it += ((m.cigarLength + 1) / 2) * 2 * sizeof(uint32_t);
+
+        if ((m.qryIdx >= length(qryIds)) || (m.subjIdx >= length(subjIds)))
+        {
+            std::cerr << "\nThe input file refers to query " << m.qryIdx << " and subject " << m.subjIdx
+                      << ", but there are only " << length(qryIds) << " queries and " << length(subjIds)
+                      << " subjects. Are the query file and the database those that were searched?\n";
+            return -1;
+        }
+
+        if (m.qryIdx != curQry)
+        {
+            if (!empty(record.matches))
+                writeRecord(outfile, record);
+            record.matches.clear();
+            curQry         = m.qryIdx;
+            record.qId     = qryIds[curQry];
+            record.qLength = m.qLength;
+        }
+
+        record.matches.emplace_back(qryIds[curQry], subjIds[m.subjIdx]);
+        TBlastMatch & bm = back(record.matches);
+        bm.qStart                           = m.qStart;
+        bm.qEnd                             = m.qEnd;
+        bm.sStart                           = m.sStart;
+        bm.sEnd                             = m.sEnd;
+        bm.qLength                          = m.qLength;
+        bm.sLength                          = m.sLength;
+        bm.qFrameShift                      = m.qFrameShift;
+        bm.sFrameShift                      = m.sFrameShift;
+        bm.eValue                           = m.eValue;
+        bm.bitScore                         = m.bitScore;
+        bm.alignStats.alignmentScore        = m.score;
+        bm.alignStats.alignmentLength       = m.alignLength;
+        bm.alignStats.numMatches            = m.numMatches;
+        bm.alignStats.numMismatches         = m.numMismatches;
+        bm.alignStats.numPositiveScores     = m.numPositive;
+        bm.alignStats.numGaps               = m.numGaps;
+        bm.alignStats.numGapOpens           = m.numGapOpens;
+        bm.alignStats.alignmentIdentity     = m.identity;
+        bm.alignStats.alignmentSimilarity   = m.similarity;
+    }
+
+    if (!empty(record.matches))
+        writeRecord(outfile, record);
+
+    return 0;
+}
+
+// --------------------------------------------------------------------------
+// Function main()
+// --------------------------------------------------------------------------
+
+// Program entry point.
+
+int main(int argc, char const ** argv)
+{
+    // Parse the command line.
+    LambdaConvertOptions options;
+    ArgumentParser::ParseResult res = parseCommandLine(options, argc, argv);
+
+    // If there was an error parsing or built-in argument parser functionality
+    // was triggered then we exit the program.  The return code is 1 if there
+    // were errors and 0 if there were none.
+    if (res != ArgumentParser::PARSE_OK)
+        return res == ArgumentParser::PARSE_ERROR;
+
+    double start = sysTime();
+    myPrint(options, 1, "Reading binary output...");
+
+    String<char, MMap<> > file;
+    if (!open(file, options.input.c_str(), OPEN_RDONLY))
+    {
+        std::cerr << "\nCould not open the input file " << options.input
+                  << ", make sure it exists and is readable.\n";
+        return -1;
+    }
+
+    BinaryHeader h;
+    std::string qryFile;
+    std::string dbFile;
+    if (readBinaryHeader(h, qryFile, dbFile, file))
+    {
+        std::cerr << "\n" << options.input << " is not a binary output file of this version of lambda.\n";
+        return -1;
+    }
+
+    // ids are looked up in the files that were searched
+    StringSet<CharString, Owner<ConcatDirect<> > > qryIds;
+    if (loadQryIds(qryIds, options.queryFile.empty() ? qryFile : options.queryFile))
+        return -1;
+
+    StringSet<String<char, MMap<> >, Owner<ConcatDirect<> > > subjIds;
+    std::string idsFile = (options.dbFile.empty() ? dbFile : options.dbFile) + ".ids";
+    if (!open(subjIds, idsFile.c_str(), OPEN_RDONLY))
+    {
+        std::cerr << "\nCould not open " << idsFile << ", make sure the database exists and is readable "
+                  << "(or pass its new location with -d).\n";
+        return -1;
+    }
+    myPrint(options, 1, " done.\n");
+    myPrint(options, 2, "Runtime: ", sysTime() - start, "s \n\n");
+
+    start = sysTime();
+    myPrint(options, 1, "Writing ", options.output, "...");
+
+    BlastTabularFileOut<BlastIOContext<> > outfile;
+    if (!open(outfile, options.output.c_str()))
+    {
+        std::cerr << "\nCould not open the output file " << options.output
+                  << ", make sure the directory exists and is writable.\n";
+        return -1;
+    }
+
+    // reproduce what lambda would have written
+    CharString output = options.output;
+    if (endsWith(output, ".gz"))
+        output = prefix(output, length(output) - 3);
+    else if (endsWith(output, ".bz2"))
+        output = prefix(output, length(output) - 4);
+
+    context(outfile).tabularSpec  = endsWith(output, ".m9") ? BlastTabularSpec::COMMENTS
+                                                             : BlastTabularSpec::NO_COMMENTS;
+    context(outfile).blastProgram = static_cast<BlastProgram>(h.blastProgram);
+    context(outfile).dbName       = dbFile;
+    context(outfile).fields       = options.columns;
+
+    int ret = 0;
+    try
+    {
+        writeHeader(outfile);
+        ret = convert(outfile, h, file, qryIds, subjIds);
+        if (!ret)
+            writeFooter(outfile);
+    }
+    catch(IOError const & e)
+    {
+        std::cerr << "\nIOError thrown: " << e.what() << '\n'
+                  << "Could not write to the output file.\n";
+        return -1;
+    }
+    close(outfile);
+
+    myPrint(options, 1, " done.\n");
+    myPrint(options, 2, "Runtime: ", sysTime() - start, "s \n\n");
+    return ret;
+}
@@ -229,7 +229,13 @@ realMain(LambdaIndexerOptions     const & options,
     if (!checkIndexSize(translatedSeqs))
         return -1;
 
-    if (options.dbIndexType == 1)
+    if (options.dbIndexType == 2)
+    {
+        generateKmerIndexAndDump(translatedSeqs,
+                                 options,
+                                 BlastProgramSelector<p>(),
+                                 TRedAlph());
+    } else if (options.dbIndexType == 1)
     {
         using TIndexSpec = TFMIndex<TIndexSpecSpec>;
         generateIndexAndDump<TIndexSpec,TIndexSpecSpec>(translatedSeqs,
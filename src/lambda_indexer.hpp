@@ -38,7 +38,9 @@
 
 #include "misc.hpp"
 #include "options.hpp"
+#include "input.hpp"
 #include "alph.hpp"
+#include "kmer_index.hpp"
 #include "index_sa_sort.h"
 #include "lambda_indexer_misc.h"
 
@@ -58,8 +60,13 @@ loadSubjSeqsAndIds(TCDStringSet<String<TOrigAlph>> & originalSeqs,
     double start = sysTime();
     myPrint(options, 1, "Loading Subject Sequences and Ids...");
 
-    SeqFileIn infile(toCString(options.dbFile));
-    int ret = myReadRecords(ids, originalSeqs, infile);
+    // parallel and memory mapped for FASTA/FASTQ, seqan's reader otherwise
+    int ret = myReadRecordsParallel(ids, originalSeqs, options.dbFile, options.threads);
+    if (ret == 1)
+    {
+        SeqFileIn infile(toCString(options.dbFile));
+        ret = myReadRecords(ids, originalSeqs, infile);
+    }
     if (ret)
         return ret;
 
@@ -493,4 +500,67 @@ generateIndexAndDump(StringSet<TString, TSpec>        & seqs,
     myPrint(options, 2, "Runtime: ", e, "s \n");
 }
 
+// the k-mer index is a q-gram index with open addressing, its shape is not
+// saved, so k is part of the file name
+template <typename TString,
+          typename TSpec,
+          typename TRedAlph_,
+          BlastProgram p>
+inline void
+generateKmerIndexAndDump(StringSet<TString, TSpec>        & seqs,
+                         LambdaIndexerOptions       const & options,
+                         BlastProgramSelector<p>    const &,
+                         TRedAlph_                  const &)
+{
+    using TTransSeqs    = TCDStringSet<String<TransAlph<p>>>;
+
+    using TRedAlph      = RedAlph<p, TRedAlph_>; // ensures == Dna5 for BlastN
+    using TRedSeqVirt   = ModifiedString<String<TransAlph<p>, Alloc<>>,
+                            ModView<FunctorConvert<TransAlph<p>,TRedAlph>>>;
+    using TRedSeqsVirt  = StringSet<TRedSeqVirt, Owner<ConcatDirect<>>>;
+
+    static bool constexpr
+    alphReduction       = !std::is_same<TransAlph<p>, TRedAlph>::value;
+
+    using TRedSeqs      = typename std::conditional<
+                            !alphReduction,
+                            TTransSeqs,             // owner
+                            TRedSeqsVirt>::type;    // modview
+    using TRedSeqsACT   = typename std::conditional<
+                            !alphReduction,
+                            TTransSeqs &,           // reference to owner
+                            TRedSeqsVirt>::type;    // modview
+
+    using TDbIndex      = Index<TRedSeqs, TKmerIndex>;
+
+    // Generate Index
+    myPrint(options, 1, "Generating Index...");
+    double s = sysTime();
+
+    TRedSeqsACT redSubjSeqs(seqs);
+
+    TDbIndex dbIndex(redSubjSeqs);
+    createKmerIndex(dbIndex, options.seedLength);
+
+    // since we dumped unreduced sequences before and reduced sequences are
+    // only "virtual" we clear them before dump
+    clear(seqs);
+    if (alphReduction)
+        clear(redSubjSeqs.limits);
+
+    double e = sysTime() - s;
+    myPrint(options, 1, " done.\n");
+    myPrint(options, 2, "Runtime: ", e, "s \n\n");
+
+    // Dump Index
+    myPrint(options, 1, "Writing Index to disk...");
+    s = sysTime();
+    std::string path = toCString(options.dbFile);
+    path += '.' + std::string(_alphName(TRedAlph())) + ".kmer" + std::to_string(options.seedLength);
+    save(dbIndex, path.c_str());
+    e = sysTime() - s;
+    myPrint(options, 1, " done.\n");
+    myPrint(options, 2, "Runtime: ", e, "s \n");
+}
+
 #endif // header guard
@@ -190,12 +190,13 @@ template <typename TSpec1,
 inline int
 myReadRecords(TCDStringSet<String<char, TSpec1>> & ids,
               TCDStringSet<String<Dna5, TSpec2>> & seqs,
-              TFile                               & file)
+              TFile                               & file,
+              uint64_t                      const   maxRecords = MaxValue<uint64_t>::VALUE)
 {
     TCDStringSet<String<Iupac>> tmpSeqs; // all IUPAC nucleic acid characters are valid input
     try
     {
-        readRecords(ids, tmpSeqs, file);
+        readRecords(ids, tmpSeqs, file, maxRecords);
     }
     catch(ParseError const & e)
     {
@@ -217,11 +218,12 @@ template <typename TSpec1,
 inline int
 myReadRecords(TCDStringSet<String<char, TSpec1>>       & ids,
               TCDStringSet<String<AminoAcid, TSpec2>>  & seqs,
-              TFile                                     & file)
+              TFile                                     & file,
+              uint64_t                            const   maxRecords = MaxValue<uint64_t>::VALUE)
 {
     try
     {
-        readRecords(ids, seqs, file);
+        readRecords(ids, seqs, file, maxRecords);
     }
     catch(ParseError const & e)
     {
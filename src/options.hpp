@@ -102,6 +102,9 @@ struct LambdaFMIndexConfig
 template <typename TSpec = void>
 using TFMIndex = FMIndex<TSpec, LambdaFMIndexConfig>;
 
+// hash table of the k-mers (k = seed length), see kmer_index.hpp
+using TKmerIndex = IndexQGram<SimpleShape, OpenAddressing>;
+
 // lazy...
 template <typename TString>
 using TCDStringSet = StringSet<TString, Owner<ConcatDirect<> > >;
@@ -208,9 +211,13 @@ struct LambdaOptions : public SharedOptions
 
     std::string     queryFile;
     bool            revComp     = true;
+    uint64_t        queryChunkSize = 0; // 0 = load all queries at once
 
     std::string     output;
     std::vector<BlastMatchField<>::Enum> columns;
+    bool            orderedOutput = false;
+    bool            binaryOutput = false; // .m8b, see binary_output.hpp
+    bool            binaryCigar = false;
 
     unsigned        queryPart = 0;
 
@@ -221,10 +228,18 @@ struct LambdaOptions : public SharedOptions
     unsigned        seedLength  = 0;
     unsigned        maxSeedDist = 1;
     bool            hammingOnly = true;
+    // seeds with mismatches are found by exact search of their parts, see
+    // pigeonholeFind()
+    bool            pigeonhole  = false;
 
     int             seedGravity     = 0;
     unsigned        seedOffset      = 0;
     unsigned        minSeedLength   = 0;
+    // seeds with more occurrences are skipped, 0 = no limit
+    unsigned        maxSubjSeedOcc  = 0;
+    unsigned        maxQrySeedOcc   = 0;
+    // seeds per thread whose SA intervals are cached without query index
+    unsigned        seedCacheSize   = 0;
 
 //     unsigned int    minSeedEVal     = 0;
 //     double          minSeedBitS     = -1;
@@ -241,6 +256,9 @@ struct LambdaOptions : public SharedOptions
     int             band        = -1;
     double          eCutOff     = 0;
     int             idCutOff    = 0;
+    // false if neither the output nor -id needs identity, mismatches, gaps
+    // etc., see needsAlignStats()
+    bool            computeAlignStats = true;
     unsigned long   maxMatches  = 500;
 
     bool            filterPutativeDuplicates = true;
@@ -259,12 +277,26 @@ struct LambdaIndexerOptions : public SharedOptions
 {
     std::string     segFile = "";
     std::string     algo = "";
+    // k of the k-mer index
+    unsigned        seedLength = 0;
 
     LambdaIndexerOptions()
         : SharedOptions()
     {}
 };
 
+struct LambdaConvertOptions : public SharedOptions
+{
+    std::string     input;          // .m8b
+    std::string     output;         // .m8 or .m9
+    std::string     queryFile;      // if empty, the one stored in input
+    std::vector<BlastMatchField<>::Enum> columns;
+
+    LambdaConvertOptions()
+        : SharedOptions()
+    {}
+};
+
 // ==========================================================================
 // Functions
 // ==========================================================================
@@ -318,6 +350,84 @@ sharedSetup(ArgumentParser & parser)
         "<https://github.com/seqan/lambda/wiki>");
 }
 
+// --------------------------------------------------------------------------
+// Function parseOutputColumns()
+// --------------------------------------------------------------------------
+
+// -oc argument of lambda and lambda_convert
+inline ArgumentParser::ParseResult
+parseOutputColumns(std::vector<BlastMatchField<>::Enum> & columns, std::string const & buffer)
+{
+    if (buffer == "help")
+    {
+        std::cout << "Please specify the columns in this format -oc 'column1 column2', i.e. space-seperated and "
+                  << "enclosed in single quotes.\nThe specifiers are the same as in NCBI Blast, currently "
+                  << "the following are supported:\n";
+        for (unsigned i = 0; i < length(BlastMatchField<>::implemented); ++i)
+        {
+            if (BlastMatchField<>::implemented[i])
+            {
+                std::cout << "\t" << BlastMatchField<>::optionLabels[i]
+                          << (length(BlastMatchField<>::optionLabels[i]) >= 8 ? "\t" : "\t\t")
+                          << BlastMatchField<>::descriptions[i] << "\n";
+            }
+        }
+        return ArgumentParser::PARSE_HELP;
+    }
+
+    StringSet<CharString> fields;
+    strSplit(fields, buffer, IsSpace(), false);
+    for (auto str : fields)
+    {
+        bool resolved = false;
+        for (unsigned i = 0; i < length(BlastMatchField<>::optionLabels); ++i)
+        {
+            if (BlastMatchField<>::optionLabels[i] == str)
+            {
+                columns.push_back(static_cast<BlastMatchField<>::Enum>(i));
+                resolved = true;
+                break;
+            }
+        }
+        if (!resolved)
+        {
+            std::cerr << "Unknown column specifier \"" << str << "\". Please see -oc help for valid options.\n";
+            return ArgumentParser::PARSE_ERROR;
+        }
+    }
+    return ArgumentParser::PARSE_OK;
+}
+
+// --------------------------------------------------------------------------
+// Function needsAlignStats()
+// --------------------------------------------------------------------------
+
+// whether a column is printed from BlastMatch::alignStats (other than score)
+inline bool
+needsAlignStats(BlastMatchField<>::Enum const column)
+{
+    switch (column)
+    {
+        case BlastMatchField<>::Enum::Q_SEQ_ID:
+        case BlastMatchField<>::Enum::Q_LEN:
+        case BlastMatchField<>::Enum::S_SEQ_ID:
+        case BlastMatchField<>::Enum::S_LEN:
+        case BlastMatchField<>::Enum::Q_START:
+        case BlastMatchField<>::Enum::Q_END:
+        case BlastMatchField<>::Enum::S_START:
+        case BlastMatchField<>::Enum::S_END:
+        case BlastMatchField<>::Enum::E_VALUE:
+        case BlastMatchField<>::Enum::BIT_SCORE:
+        case BlastMatchField<>::Enum::SCORE:
+        case BlastMatchField<>::Enum::FRAMES:
+        case BlastMatchField<>::Enum::Q_FRAME:
+        case BlastMatchField<>::Enum::S_FRAME:
+            return false;
+        default: // STD, P_IDENT, LENGTH, ... and everything not implemented
+            return true;
+    }
+}
+
 // --------------------------------------------------------------------------
 // Function parseCommandLine()
 // --------------------------------------------------------------------------
@@ -350,8 +460,16 @@ parseCommandLine(LambdaOptions & options, int argc, char const ** argv)
     setValidValues(parser, "query", toCString(concat(getFileExtensions(SeqFileIn()), ' ')));
     setRequired(parser, "q");
 
+    addOption(parser, ArgParseOption("qc", "query-chunk-size",
+        "Read, search and write the query file in chunks of this many sequences instead of loading it completely; "
+        "caps the memory used for queries and produces first results early (0 -> no chunking).",
+        ArgParseArgument::INT64));
+    setDefaultValue(parser, "query-chunk-size", "0");
+    setMinValue(parser, "query-chunk-size", "0");
+    setAdvanced(parser, "query-chunk-size");
+
     addOption(parser, ArgParseOption("d", "database",
-        "Path to original database sequences (a precomputed index with .sa or .fm needs to exist!).",
+        "Path to original database sequences (a precomputed index with .sa, .fm or .kmer needs to exist!).",
         ArgParseArgument::INPUT_FILE,
         "IN"));
     setValidValues(parser, "database", toCString(concat(getFileExtensions(SeqFileIn()), ' ')));
@@ -362,19 +480,21 @@ parseCommandLine(LambdaOptions & options, int argc, char const ** argv)
 //         "(auto means \"try sa first then fm\").",
         ArgParseArgument::STRING,
         "STR"));
-    setValidValues(parser, "db-index-type", "sa fm");
+    setValidValues(parser, "db-index-type", "sa fm kmer");
     setDefaultValue(parser, "db-index-type", "fm");
     setAdvanced(parser, "db-index-type");
 
     addSection(parser, "Output Options");
     addOption(parser, ArgParseOption("o", "output",
         "File to hold reports on hits (.m* are blastall -m* formats; .m8 is tab-seperated, .m9 is tab-seperated with "
-        "with comments, .m0 is pairwise format).",
+        "with comments, .m0 is pairwise format; .m8b is a compact binary format that lambda_convert turns into "
+        ".m8 or .m9).",
         ArgParseArgument::OUTPUT_FILE,
         "OUT"));
     CharString exts = concat(getFileExtensions(BlastTabularFileOut<>()), ' ');
     appendValue(exts, ' ');
     append(exts, concat(getFileExtensions(BlastReportFileOut<>()), ' '));
+    append(exts, " .m8b");
 
     setValidValues(parser, "output", toCString(exts));
     setDefaultValue(parser, "output", "output.m8");
@@ -386,8 +506,23 @@ parseCommandLine(LambdaOptions & options, int argc, char const ** argv)
     setDefaultValue(parser, "output-columns", "std");
     setAdvanced(parser, "output-columns");
 
+    addOption(parser, ArgParseOption("oo", "output-ordered",
+        "Write records in the order of the query file, independent of the number of threads "
+        "(costs a little memory for results that are finished early).",
+        ArgParseArgument::STRING));
+    setValidValues(parser, "output-ordered", "on off");
+    setDefaultValue(parser, "output-ordered", "off");
+    setAdvanced(parser, "output-ordered");
+
+    addOption(parser, ArgParseOption("", "output-cigar",
+        "Store the alignment of every match as CIGAR in binary output (.m8b only).",
+        ArgParseArgument::STRING));
+    setValidValues(parser, "output-cigar", "on off");
+    setDefaultValue(parser, "output-cigar", "off");
+    setAdvanced(parser, "output-cigar");
+
     addOption(parser, ArgParseOption("id", "percent-identity",
-        "Output only matches above this threshold (checked before e-value "
+        "Output only matches above this threshold (checked after e-value "
         "check).",
         ArgParseArgument::INTEGER));
     setDefaultValue(parser, "percent-identity", "0");
@@ -513,6 +648,18 @@ parseCommandLine(LambdaOptions & options, int argc, char const ** argv)
     setDefaultValue(parser, "seed-delta", "1");
     setAdvanced(parser, "seed-delta");
 
+    addOption(parser, ArgParseOption("", "seeding-engine",
+        "how seeds with mismatches are searched: backtracking in the index, "
+        "or exact search of seed-delta + 1 parts of the seed followed by "
+        "verification (pigeonhole). Without query index both find the same "
+        "hits; with a query index (-qi) the backtracking reports some hits "
+        "twice and finds a few more, so the hit counts and in rare cases "
+        "the output differ.",
+        ArgParseArgument::STRING));
+    setValidValues(parser, "seeding-engine", "backtracking pigeonhole");
+    setDefaultValue(parser, "seeding-engine", "backtracking");
+    setAdvanced(parser, "seeding-engine");
+
     addOption(parser, ArgParseOption("sg", "seed-gravity",
         "Seeds closer than this are merged into region (if unset = "
         "seed-length).",
@@ -526,6 +673,30 @@ parseCommandLine(LambdaOptions & options, int argc, char const ** argv)
     setDefaultValue(parser, "seed-min-length", "10");
     hideOption(parser, "seed-min-length"); // HIDDEN
 
+    addOption(parser, ArgParseOption("sf", "seed-subj-occ-limit",
+        "skip seeds that occur more often than this in the database "
+        "(0 -> no limit).",
+        ArgParseArgument::INTEGER));
+    setMinValue(parser, "seed-subj-occ-limit", "0");
+    setDefaultValue(parser, "seed-subj-occ-limit", "0");
+    setAdvanced(parser, "seed-subj-occ-limit");
+
+    addOption(parser, ArgParseOption("sq", "seed-qry-occ-limit",
+        "skip seeds that occur more often than this in the queries of a "
+        "block (0 -> no limit; only with query index).",
+        ArgParseArgument::INTEGER));
+    setMinValue(parser, "seed-qry-occ-limit", "0");
+    setDefaultValue(parser, "seed-qry-occ-limit", "0");
+    setAdvanced(parser, "seed-qry-occ-limit");
+
+    addOption(parser, ArgParseOption("", "seed-cache-size",
+        "number of seeds per thread whose hits in the database are cached "
+        "between queries (0 -> no cache; only without query index).",
+        ArgParseArgument::INTEGER));
+    setMinValue(parser, "seed-cache-size", "0");
+    setDefaultValue(parser, "seed-cache-size", "100000");
+    setAdvanced(parser, "seed-cache-size");
+
     addSection(parser, "Miscellaneous Heuristics");
 
     addOption(parser, ArgParseOption("ps", "pre-scoring",
@@ -671,6 +842,7 @@ parseCommandLine(LambdaOptions & options, int argc, char const ** argv)
 
     // Extract option values.
     getOptionValue(options.queryFile, parser, "query");
+    getOptionValue(options.queryChunkSize, parser, "query-chunk-size");
 //     if (endsWith(options.queryFile, ".fastq") ||
 //         endsWith(options.queryFile, ".fq"))
 //         options.fileFormat = 1;
@@ -679,46 +851,17 @@ parseCommandLine(LambdaOptions & options, int argc, char const ** argv)
 
     getOptionValue(options.output, parser, "output");
 
+    getOptionValue(buffer, parser, "output-ordered");
+    options.orderedOutput = (buffer == "on");
+
+    options.binaryOutput = endsWith(options.output, ".m8b");
+    getOptionValue(buffer, parser, "output-cigar");
+    options.binaryCigar = options.binaryOutput && (buffer == "on");
+
     getOptionValue(buffer, parser, "output-columns");
-    if (buffer == "help")
-    {
-        std::cout << "Please specify the columns in this format -oc 'column1 column2', i.e. space-seperated and "
-                  << "enclosed in single quotes.\nThe specifiers are the same as in NCBI Blast, currently "
-                  << "the following are supported:\n";
-        for (unsigned i = 0; i < length(BlastMatchField<>::implemented); ++i)
-        {
-            if (BlastMatchField<>::implemented[i])
-            {
-                std::cout << "\t" << BlastMatchField<>::optionLabels[i]
-                          << (length(BlastMatchField<>::optionLabels[i]) >= 8 ? "\t" : "\t\t")
-                          << BlastMatchField<>::descriptions[i] << "\n";
-            }
-        }
-        return ArgumentParser::PARSE_HELP;
-    }
-    else
-    {
-        StringSet<CharString> fields;
-        strSplit(fields, buffer, IsSpace(), false);
-        for (auto str : fields)
-        {
-            bool resolved = false;
-            for (unsigned i = 0; i < length(BlastMatchField<>::optionLabels); ++i)
-            {
-                if (BlastMatchField<>::optionLabels[i] == str)
-                {
-                    appendValue(options.columns, static_cast<BlastMatchField<>::Enum>(i));
-                    resolved = true;
-                    break;
-                }
-            }
-            if (!resolved)
-            {
-                std::cerr << "Unknown column specifier \"" << str << "\". Please see -oc help for valid options.\n";
-                return ArgumentParser::PARSE_ERROR;
-            }
-        }
-    }
+    ArgumentParser::ParseResult colRes = parseOutputColumns(options.columns, buffer);
+    if (colRes != ArgumentParser::PARSE_OK)
+        return colRes;
     clear(buffer);
 
     getOptionValue(options.seedLength, parser, "seed-length");
@@ -731,6 +874,10 @@ parseCommandLine(LambdaOptions & options, int argc, char const ** argv)
     else
         options.seedOffset = options.seedLength;
 
+    getOptionValue(options.maxSubjSeedOcc, parser, "seed-subj-occ-limit");
+    getOptionValue(options.maxQrySeedOcc, parser, "seed-qry-occ-limit");
+    getOptionValue(options.seedCacheSize, parser, "seed-cache-size");
+
     if (isSet(parser, "seed-gravity"))
         getOptionValue(options.seedGravity, parser, "seed-gravity");
     else
@@ -743,6 +890,9 @@ parseCommandLine(LambdaOptions & options, int argc, char const ** argv)
 
     getOptionValue(options.maxSeedDist, parser, "seed-delta");
 
+    getOptionValue(buffer, parser, "seeding-engine");
+    options.pigeonhole = (buffer == "pigeonhole");
+
 
     getOptionValue(buffer, parser, "query-index-type");
     options.doubleIndexing = (buffer == "radix");
@@ -750,6 +900,17 @@ parseCommandLine(LambdaOptions & options, int argc, char const ** argv)
     getOptionValue(options.eCutOff, parser, "e-value");
     getOptionValue(options.idCutOff, parser, "percent-identity");
 
+    // the pairwise format and binary output always contain the statistics
+    if ((options.idCutOff == 0) && !options.binaryOutput &&
+        !endsWith(options.output, ".m0") && !endsWith(options.output, ".m0.gz") &&
+        !endsWith(options.output, ".m0.bz2"))
+    {
+        options.computeAlignStats = false;
+        for (auto const c : options.columns)
+            if (needsAlignStats(c))
+                options.computeAlignStats = true;
+    }
+
     getOptionValue(options.xDropOff, parser, "x-drop");
 //     if ((!isSet(parser, "x-drop")) &&
 //         (options.blastProgram == BlastProgram::BLASTN))
@@ -857,13 +1018,21 @@ parseCommandLine(LambdaIndexerOptions & options, int argc, char const ** argv)
 //     setValidValues(parser, "output", "sa fm");
 
     addOption(parser, ArgParseOption("di", "db-index-type",
-        "suffix array or full-text minute space.",
+        "suffix array, full-text minute space or hash table of k-mers.",
         ArgParseArgument::STRING,
         "type"));
-    setValidValues(parser, "db-index-type", "sa fm");
+    setValidValues(parser, "db-index-type", "sa fm kmer");
     setDefaultValue(parser, "db-index-type", "fm");
     setAdvanced(parser, "db-index-type");
 
+    addOption(parser, ArgParseOption("sl", "seed-length",
+        "Length of the k-mers in the index if db-index-type == kmer, has to be the seed length used with lambda "
+        "(default = 14 for BLASTN).",
+        ArgParseArgument::INTEGER));
+    setDefaultValue(parser, "seed-length", "10");
+    setMinValue(parser, "seed-length", "1");
+    setAdvanced(parser, "seed-length");
+
     addSection(parser, "Alphabets and Translation");
     addOption(parser, ArgParseOption("p", "program",
         "Blast Operation Mode.",
@@ -957,6 +1126,9 @@ parseCommandLine(LambdaIndexerOptions & options, int argc, char const ** argv)
     addText(parser, "Note that the indexes created are binary and not compatible between different CPU endiannesses. "
         "Also the on-disk format is still subject to change between Lambda versions.");
 
+    addText(parser, "The hash table of the kmer index depends on whether lambda_indexer was built with SSE4.2, so it "
+        "has to be used with a lambda built the same way.");
+
     // Parse command line.
     ArgumentParser::ParseResult res = parse(parser, argc, argv);
 
@@ -972,12 +1144,86 @@ parseCommandLine(LambdaIndexerOptions & options, int argc, char const ** argv)
     // Extract option values
     getOptionValue(options.segFile, parser, "segfile");
     getOptionValue(options.algo, parser, "algorithm");
+
+    getOptionValue(options.seedLength, parser, "seed-length");
+    if ((!isSet(parser, "seed-length")) &&
+        (options.blastProgram == BlastProgram::BLASTN))
+        options.seedLength = 14;
     getOptionValue(tmpdir, parser, "tmp-dir");
     setEnv("TMPDIR", tmpdir);
 
     return ArgumentParser::PARSE_OK;
 }
 
+// CONVERTER
+ArgumentParser::ParseResult
+parseCommandLine(LambdaConvertOptions & options, int argc, char const ** argv)
+{
+    // Setup ArgumentParser.
+    ArgumentParser parser("lambda_convert");
+
+    // Define usage line and long description.
+    addUsageLine(parser, "[\\fIOPTIONS\\fP] \\fIINPUT.m8b\\fP \\fI-o output.m8\\fP");
+
+    sharedSetup(parser);
+
+    addDescription(parser, "Converts lambda's binary output (.m8b) to BLAST tabular format. The query file and "
+                           "the database that were searched are needed to look up the ids.");
+
+    addArgument(parser, ArgParseArgument(ArgParseArgument::INPUT_FILE, "IN"));
+    setValidValues(parser, 0, ".m8b");
+
+    addSection(parser, "Input Options");
+    addOption(parser, ArgParseOption("q", "query",
+        "Query sequences (default: path stored in the input file).",
+        ArgParseArgument::INPUT_FILE,
+        "IN"));
+    setValidValues(parser, "query", toCString(concat(getFileExtensions(SeqFileIn()), ' ')));
+
+    addOption(parser, ArgParseOption("d", "database",
+        "Database that was searched (default: path stored in the input file).",
+        ArgParseArgument::INPUT_FILE,
+        "IN"));
+    setValidValues(parser, "database", toCString(concat(getFileExtensions(SeqFileIn()), ' ')));
+
+    addSection(parser, "Output Options");
+    addOption(parser, ArgParseOption("o", "output",
+        "File to hold reports on hits (.m8 is tab-seperated, .m9 is tab-seperated with with comments).",
+        ArgParseArgument::OUTPUT_FILE,
+        "OUT"));
+    setValidValues(parser, "output", toCString(concat(getFileExtensions(BlastTabularFileOut<>()), ' ')));
+    setDefaultValue(parser, "output", "output.m8");
+
+    addOption(parser, ArgParseOption("oc", "output-columns",
+        "Print specified column combination and/or order; call -oc help for more details.",
+        ArgParseArgument::STRING,
+        "STR"));
+    setDefaultValue(parser, "output-columns", "std");
+
+    // Parse command line.
+    ArgumentParser::ParseResult res = parse(parser, argc, argv);
+
+    // Only extract  options if the program will continue after parseCommandLine()
+    if (res != ArgumentParser::PARSE_OK)
+        return res;
+
+    std::string buffer;
+
+    getArgumentValue(options.input, parser, 0);
+    getOptionValue(options.queryFile, parser, "query");
+    getOptionValue(options.dbFile, parser, "database");
+    getOptionValue(options.output, parser, "output");
+
+    getOptionValue(buffer, parser, "output-columns");
+    res = parseOutputColumns(options.columns, buffer);
+    if (res != ArgumentParser::PARSE_OK)
+        return res;
+
+    getOptionValue(options.verbosity, parser, "verbosity");
+
+    return ArgumentParser::PARSE_OK;
+}
+
 // SHARED
 ArgumentParser::ParseResult
 parseCommandLineShared(SharedOptions & options, ArgumentParser & parser)
@@ -990,6 +1236,8 @@ parseCommandLineShared(SharedOptions & options, ArgumentParser & parser)
     getOptionValue(buffer, parser, "db-index-type");
     if (buffer == "sa")
         options.dbIndexType = 0;
+    else if (buffer == "kmer")
+        options.dbIndexType = 2;
     else // if fm
         options.dbIndexType = 1;
 
@@ -1107,13 +1355,21 @@ printOptions(LambdaOptions const & options)
     std::cout << "OPTIONS\n"
               << " INPUT\n"
               << "  query file:               " << options.queryFile << "\n"
+              << "  query chunk size:         " << (options.queryChunkSize
+                                                    ? std::to_string(options.queryChunkSize)
+                                                    : std::string("all")) << "\n"
               << "  db file:                  " << options.dbFile << "\n"
               << "  db index type:            " << (TGH::indexIsFM
                                                     ? "FM-Index\n"
-                                                    : "SA-Index\n")
+                                                    : TGH::indexIsKmer
+                                                      ? "k-mer Index\n"
+                                                      : "SA-Index\n")
               << " OUTPUT (file)\n"
               << "  output file:              " << options.output << "\n"
+              << "  ordered output:           " << (options.orderedOutput ? "on" : "off") << "\n"
+              << "  binary output CIGAR:      " << (options.binaryCigar ? "on" : "off") << "\n"
               << "  minimum % identity:       " << options.idCutOff << "\n"
+              << "  alignment statistics:     " << (options.computeAlignStats ? "on" : "off (not needed)") << "\n"
               << "  maximum e-value:          " << options.eCutOff << "\n"
               << "  max #matches per query:   " << options.maxMatches << "\n"
               << " OUTPUT (stdout)\n"
@@ -1147,8 +1403,20 @@ printOptions(LambdaOptions const & options)
               << "  seed offset:              " << uint(options.seedOffset) << "\n"
               << "  seed delta:               " << uint(options.maxSeedDist) << "\n"
               << "  seeds ungapped:           " << uint(options.hammingOnly) << "\n"
+              << "  seeding engine:           " << (options.pigeonhole
+                                                    ? std::string("pigeonhole")
+                                                    : std::string("backtracking")) << "\n"
               << "  seed gravity:             " << uint(options.seedGravity) << "\n"
               << "  min seed length:          " << uint(options.minSeedLength) << "\n"
+              << "  seed subj. occ. limit:    " << (options.maxSubjSeedOcc
+                                                    ? std::to_string(options.maxSubjSeedOcc)
+                                                    : std::string("none")) << "\n"
+              << "  seed qry. occ. limit:     " << (options.maxQrySeedOcc
+                                                    ? std::to_string(options.maxQrySeedOcc)
+                                                    : std::string("none")) << "\n"
+              << "  seed cache size:          " << (options.doubleIndexing
+                                                    ? std::string("n/a")
+                                                    : std::to_string(options.seedCacheSize)) << "\n"
               << " MISCELLANEOUS HEURISTICS\n"
               << "  pre-scoring:              " << (options.preScoring
                                                     ? std::string("on")
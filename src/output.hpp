@@ -0,0 +1,353 @@
+// ==========================================================================
+//                                  lambda
+// ==========================================================================
+// Copyright (c) 2013-2015, Hannes Hauswedell, FU Berlin
+// All rights reserved.
+//
+// This file is part of Lambda.
+//
+// Lambda is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Lambda is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with Lambda.  If not, see <http://www.gnu.org/licenses/>.*/
+// ==========================================================================
+// Author: Hannes Hauswedell <hannes.hauswedell @ fu-berlin.de>
+// ==========================================================================
+// output.hpp: asynchronous output writer
+// ==========================================================================
+
+#ifndef SEQAN_LAMBDA_OUTPUT_H_
+#define SEQAN_LAMBDA_OUTPUT_H_
+
+#include <atomic>
+#include <fstream>
+#include <thread>
+#include <chrono>
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <seqan/basic.h>
+#include <seqan/blast.h>
+
+using namespace seqan;
+
+// ============================================================================
+// Tags, Classes, Enums
+// ============================================================================
+
+// ----------------------------------------------------------------------------
+// struct OutputChunk  -- formatted records handed to the writer
+// ----------------------------------------------------------------------------
+
+struct OutputChunk
+{
+    std::string buffer;     // formatted text of one or more records
+    uint64_t    nRecords;   // number of records in buffer
+    uint64_t    blockId;    // block the records belong to
+    bool        blockDone;  // last chunk of this block (only for ordered output)
+};
+
+// ----------------------------------------------------------------------------
+// class BgzfOutStream  -- gzip compatible output compressed by n threads
+// ----------------------------------------------------------------------------
+
+// seqan's VirtualStream compresses .gz on the calling thread; BGZF is a series
+// of independent gzip members that any gzip reader (zcat) accepts, and seqan's
+// bgzf streambuf compresses these blocks in parallel. Unlike bgzf_ostream this
+// lets us choose the number of compression threads.
+
+class BgzfOutStream : public std::ostream
+{
+    basic_bgzf_streambuf<char>  buf;
+
+public:
+    BgzfOutStream(std::ostream & out, size_t const numThreads) :
+        std::ostream(nullptr), buf(out, numThreads)
+    {
+        this->init(&buf);
+    }
+
+    ~BgzfOutStream()
+    {
+        // flush the last block, the destructor of buf adds the EOF block
+        buf.addFooter();
+    }
+};
+
+// ----------------------------------------------------------------------------
+// class BoundedQueue  -- lock-free multi-producer/multi-consumer ring buffer
+// ----------------------------------------------------------------------------
+
+// after D. Vyukov's bounded MPMC queue; every cell carries a sequence number
+// that tells producers and consumers whether it is free or filled in the
+// current round, so the only shared write is one CAS on the position counter
+
+template <typename TValue>
+class BoundedQueue
+{
+    struct Cell
+    {
+        std::atomic<uint64_t> seq;
+        TValue                data;
+    };
+
+    std::vector<Cell>       cells;
+    uint64_t                mask;
+
+    // keep producer and consumer positions on different cache lines
+    alignas(64) std::atomic<uint64_t> enqPos;
+    alignas(64) std::atomic<uint64_t> deqPos;
+
+public:
+    BoundedQueue() :
+        mask(0), enqPos(0), deqPos(0)
+    {}
+
+    // (re-)initialize empty queue; capacity is rounded up to a power of two
+    void init(uint64_t const capacity)
+    {
+        uint64_t size = 2;
+        while (size < capacity)
+            size <<= 1;
+        mask = size - 1;
+        cells = std::vector<Cell>(size);
+        for (uint64_t i = 0; i < size; ++i)
+            cells[i].seq.store(i, std::memory_order_relaxed);
+        enqPos.store(0, std::memory_order_relaxed);
+        deqPos.store(0, std::memory_order_relaxed);
+    }
+
+    bool tryPush(TValue & v)
+    {
+        uint64_t pos = enqPos.load(std::memory_order_relaxed);
+        Cell * cell;
+        for (;;)
+        {
+            cell = &cells[pos & mask];
+            uint64_t const seq = cell->seq.load(std::memory_order_acquire);
+            int64_t const dif = static_cast<int64_t>(seq) - static_cast<int64_t>(pos);
+            if (dif == 0)
+            {
+                if (enqPos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+                    break;
+            }
+            else if (dif < 0)
+            {
+                return false; // full
+            }
+            else
+            {
+                pos = enqPos.load(std::memory_order_relaxed);
+            }
+        }
+        std::swap(cell->data, v);
+        cell->seq.store(pos + 1, std::memory_order_release);
+        return true;
+    }
+
+    bool tryPop(TValue & v)
+    {
+        uint64_t pos = deqPos.load(std::memory_order_relaxed);
+        Cell * cell;
+        for (;;)
+        {
+            cell = &cells[pos & mask];
+            uint64_t const seq = cell->seq.load(std::memory_order_acquire);
+            int64_t const dif = static_cast<int64_t>(seq) - static_cast<int64_t>(pos + 1);
+            if (dif == 0)
+            {
+                if (deqPos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+                    break;
+            }
+            else if (dif < 0)
+            {
+                return false; // empty
+            }
+            else
+            {
+                pos = deqPos.load(std::memory_order_relaxed);
+            }
+        }
+        std::swap(cell->data, v);
+        cell->seq.store(pos + mask + 1, std::memory_order_release);
+        return true;
+    }
+};
+
+// ----------------------------------------------------------------------------
+// class OutputWriter  -- one thread doing all file I/O
+// ----------------------------------------------------------------------------
+
+// Worker threads format their records into thread-local buffers and push()
+// them here; the writer thread is the only one that touches the file, so
+// formatting runs in parallel and (de)compression overlaps with the search.
+// If ordered, chunks of blocks that finish early are held back until all
+// preceding blocks are written, so that output follows the query file.
+
+template <typename TFile>
+class OutputWriter
+{
+    struct PendingBlock
+    {
+        std::vector<OutputChunk> chunks;
+        bool                     done = false;
+    };
+
+    TFile &                     file;
+    BoundedQueue<OutputChunk>   queue;
+    std::thread                 thread;
+    std::atomic<bool>           done;
+    bool                        failed;
+    std::string                 errorMsg;
+
+    // ordered output
+    bool                        ordered;
+    uint64_t                    window;     // max. #blocks ahead of nextBlock
+    std::atomic<uint64_t>       nextBlock;  // first block not completely written
+    std::map<uint64_t, PendingBlock> pending;
+
+    void run()
+    {
+        OutputChunk chunk;
+        unsigned idle = 0;
+        for (;;)
+        {
+            if (queue.tryPop(chunk))
+            {
+                idle = 0;
+                dispatch(chunk);
+            }
+            else if (done.load(std::memory_order_acquire))
+            {
+                // producers have finished, drain what is left
+                while (queue.tryPop(chunk))
+                    dispatch(chunk);
+                break;
+            }
+            else if (++idle < 64)
+            {
+                std::this_thread::yield();
+            }
+            else
+            {
+                std::this_thread::sleep_for(std::chrono::microseconds(100));
+            }
+        }
+    }
+
+    void dispatch(OutputChunk & chunk)
+    {
+        if (!ordered)
+        {
+            consume(chunk);
+            return;
+        }
+
+        uint64_t next = nextBlock.load(std::memory_order_relaxed);
+        if (chunk.blockId != next)
+        {
+            // hold back
+            PendingBlock & p = pending[chunk.blockId];
+            p.done = chunk.blockDone;
+            p.chunks.push_back(std::move(chunk));
+            chunk = OutputChunk{std::string(), 0, 0, false};
+            return;
+        }
+
+        bool blockDone = chunk.blockDone;
+        consume(chunk);
+        while (blockDone)
+        {
+            nextBlock.store(++next, std::memory_order_release);
+            auto it = pending.find(next);
+            if (it == pending.end())
+                break;
+            for (OutputChunk & c : it->second.chunks)
+                consume(c);
+            blockDone = it->second.done;
+            pending.erase(it); // remaining chunks of next will not be held back
+        }
+    }
+
+    void consume(OutputChunk & chunk)
+    {
+        if (failed) // keep draining so that producers never block forever
+            return;
+        try
+        {
+            write(file.iter, chunk.buffer);
+            // the records were formatted with thread-local copies of the
+            // context, the m9 footer needs the global count
+            context(file)._numberOfRecords += chunk.nRecords;
+        }
+        catch (IOError const & e)
+        {
+            failed = true;
+            errorMsg = e.what();
+        }
+        chunk.buffer.clear();
+        chunk.nRecords = 0;
+    }
+
+public:
+    OutputWriter(TFile & _file) :
+        file(_file), done(false), failed(false), ordered(false), window(0), nextBlock(0)
+    {}
+
+    // capacity is the maximum number of chunks waiting to be written; if
+    // _ordered, every block must be terminated by a chunk with blockDone set
+    // and at most _window blocks may be processed ahead of the oldest
+    // unfinished block
+    void start(uint64_t const capacity, bool const _ordered, uint64_t const _window)
+    {
+        queue.init(capacity);
+        ordered = _ordered;
+        window = _window;
+        nextBlock.store(0, std::memory_order_relaxed);
+        done.store(false, std::memory_order_relaxed);
+        thread = std::thread([this] () { run(); });
+    }
+
+    // called by workers before starting a block, bounds the memory needed for
+    // held back blocks
+    void waitForWindow(uint64_t const blockId)
+    {
+        if (!ordered)
+            return;
+        while (blockId >= nextBlock.load(std::memory_order_acquire) + window)
+            std::this_thread::sleep_for(std::chrono::microseconds(50));
+    }
+
+    void push(OutputChunk & chunk)
+    {
+        while (!queue.tryPush(chunk))
+            std::this_thread::yield();
+    }
+
+    // wait for all pushed records to be written; returns non-zero on error
+    int finish()
+    {
+        done.store(true, std::memory_order_release);
+        if (thread.joinable())
+            thread.join();
+        if (failed)
+        {
+            std::cerr << "\nIOError thrown: " << errorMsg << '\n'
+                      << "Could not write to the output file.\n";
+            return -1;
+        }
+        return 0;
+    }
+};
+
+#endif // SEQAN_LAMBDA_OUTPUT_H_
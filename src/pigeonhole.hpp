@@ -0,0 +1,145 @@
+// ==========================================================================
+//                                  lambda
+// ==========================================================================
+// Copyright (c) 2013-2015, Hannes Hauswedell, FU Berlin
+// All rights reserved.
+//
+// This file is part of Lambda.
+//
+// Lambda is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Lambda is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with Lambda.  If not, see <http://www.gnu.org/licenses/>.*/
+// ==========================================================================
+// Author: Hannes Hauswedell <hannes.hauswedell @ fu-berlin.de>
+// ==========================================================================
+// pigeonhole.hpp: seeding with mismatches by exact search of seed parts
+// ==========================================================================
+
+#ifndef SEQAN_LAMBDA_PIGEONHOLE_H_
+#define SEQAN_LAMBDA_PIGEONHOLE_H_
+
+#include <cstdint>
+
+#include <seqan/basic.h>
+#include <seqan/sequence.h>
+#include <seqan/index.h>
+
+using namespace seqan;
+
+// A seed with at most maxDist mismatches to a subject window matches at
+// least one of maxDist + 1 disjoint parts of the seed exactly. Every part is
+// searched exactly in the database index and the windows around its
+// occurrences are verified. A window is only reported by the first part that
+// matches it exactly, so every window is reported once, as by the
+// backtracking with Hamming distance.
+
+// ----------------------------------------------------------------------------
+// Function _pigeonholePart()
+// ----------------------------------------------------------------------------
+
+// [begin, end) of part k of a seed of length len
+inline void
+_pigeonholePart(uint64_t & begin, uint64_t & end, uint64_t const k, uint64_t const parts, uint64_t const len)
+{
+    begin = k * len / parts;
+    end = (k + 1) * len / parts;
+}
+
+// ----------------------------------------------------------------------------
+// Function _pigeonholeMismatches()
+// ----------------------------------------------------------------------------
+
+// mismatches in [begin, end) of seed and the window of subj starting at
+// subjStart, stops counting after limit
+template <typename TSeed, typename TSubj>
+inline unsigned
+_pigeonholeMismatches(TSeed const & seed,
+                      TSubj const & subj,
+                      uint64_t const subjStart,
+                      uint64_t const begin,
+                      uint64_t const end,
+                      unsigned const limit)
+{
+    unsigned mismatches = 0;
+    for (uint64_t i = begin; (i < end) && (mismatches <= limit); ++i)
+        mismatches += !ordEqual(seed[i], subj[subjStart + i]);
+    return mismatches;
+}
+
+// ----------------------------------------------------------------------------
+// Function pigeonholeFind()
+// ----------------------------------------------------------------------------
+
+// appends to subjOccs the windows of subjSeqs that have at most maxDist
+// mismatches to seed, as SA values of dbIndex; for an index of the reversed
+// sequences (reversedIndex, see onFindImpl()) the offsets are reversed, too
+template <typename TSubjOccs, typename TDbIndex, typename TSubjSeqs, typename TSeed>
+inline void
+pigeonholeFind(TSubjOccs & subjOccs,
+               TDbIndex & dbIndex,
+               TSubjSeqs const & subjSeqs,
+               TSeed const & seed,
+               unsigned const maxDist,
+               bool const reversedIndex)
+{
+    using TIndexIt = typename Iterator<TDbIndex, TopDown<> >::Type;
+    using TSAValue = typename Value<TSubjOccs>::Type;
+
+    uint64_t const len = length(seed);
+    uint64_t const parts = maxDist + 1;
+
+    for (uint64_t k = 0; k < parts; ++k)
+    {
+        uint64_t pBegin, pEnd;
+        _pigeonholePart(pBegin, pEnd, k, parts, len);
+
+        TIndexIt it(dbIndex);
+        if (!goDown(it, infix(seed, pBegin, pEnd)))
+            continue;
+
+        auto const occs = getOccurrences(it);
+        for (uint64_t o = 0; o < length(occs); ++o)
+        {
+            auto const occ = occs[o];
+            auto const & subj = subjSeqs[getSeqNo(occ)];
+            uint64_t const subjLen = length(subj);
+            uint64_t const partStart = reversedIndex ? subjLen - getSeqOffset(occ) - (pEnd - pBegin)
+                                                     : getSeqOffset(occ);
+            // the window of the seed has to lie inside the subject
+            if ((partStart < pBegin) || (partStart - pBegin + len > subjLen))
+                continue;
+            uint64_t const start = partStart - pBegin;
+
+            bool reported = false; // by an earlier part
+            unsigned mismatches = 0;
+            for (uint64_t j = 0; (j < parts) && !reported && (mismatches <= maxDist); ++j)
+            {
+                if (j == k)
+                    continue;
+                uint64_t jBegin, jEnd;
+                _pigeonholePart(jBegin, jEnd, j, parts, len);
+                unsigned const m = _pigeonholeMismatches(seed, subj, start, jBegin, jEnd, maxDist - mismatches);
+                reported = (j < k) && (m == 0);
+                mismatches += m;
+            }
+            if (reported || (mismatches > maxDist))
+                continue;
+
+            TSAValue v;
+            assignValueI1(v, getSeqNo(occ));
+            assignValueI2(v, reversedIndex ? subjLen - start - len : start);
+            appendValue(subjOccs, v);
+        }
+    }
+}
+
+#endif // SEQAN_LAMBDA_PIGEONHOLE_H_
@@ -0,0 +1,373 @@
+// ==========================================================================
+//                                  lambda
+// ==========================================================================
+// Copyright (c) 2013-2015, Hannes Hauswedell, FU Berlin
+// All rights reserved.
+//
+// This file is part of Lambda.
+//
+// Lambda is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Lambda is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with Lambda.  If not, see <http://www.gnu.org/licenses/>.*/
+// ==========================================================================
+// Author: Hannes Hauswedell <hannes.hauswedell @ fu-berlin.de>
+// ==========================================================================
+// tabular_output.hpp: fast formatting of BLAST tabular match lines
+// ==========================================================================
+
+#ifndef SEQAN_LAMBDA_TABULAR_OUTPUT_H_
+#define SEQAN_LAMBDA_TABULAR_OUTPUT_H_
+
+#include <cmath>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+#include <seqan/basic.h>
+#include <seqan/blast.h>
+
+using namespace seqan;
+
+// Produces exactly the lines of seqan's writeRecord(..., BlastTabular()), but
+// appends to a reused std::string and converts numbers without printf. The
+// few values whose rounding cannot be decided safely in double arithmetic
+// (ties, huge numbers) are still handed to snprintf.
+
+// ============================================================================
+// Functions
+// ============================================================================
+
+// ----------------------------------------------------------------------------
+// Function makeTabularColumnPlan()
+// ----------------------------------------------------------------------------
+
+// resolve the STD placeholder once instead of for every match
+inline void
+makeTabularColumnPlan(std::vector<BlastMatchField<>::Enum>       & plan,
+                      std::vector<BlastMatchField<>::Enum> const & columns)
+{
+    plan.clear();
+    for (auto const c : columns)
+    {
+        if (c == BlastMatchField<>::Enum::STD)
+            plan.insert(plan.end(), std::begin(BlastMatchField<>::defaults), std::end(BlastMatchField<>::defaults));
+        else
+            plan.push_back(c);
+    }
+}
+
+// ----------------------------------------------------------------------------
+// Function _appendUInt() / _appendInt()
+// ----------------------------------------------------------------------------
+
+inline void
+_appendUInt(std::string & buffer, uint64_t v)
+{
+    char tmp[24];
+    char * p = tmp + sizeof(tmp);
+    do
+    {
+        *--p = '0' + (v % 10);
+        v /= 10;
+    } while (v);
+    buffer.append(p, tmp + sizeof(tmp) - p);
+}
+
+inline void
+_appendInt(std::string & buffer, int64_t const v)
+{
+    if (v < 0)
+    {
+        buffer.push_back('-');
+        _appendUInt(buffer, -static_cast<uint64_t>(v));
+    }
+    else
+    {
+        _appendUInt(buffer, v);
+    }
+}
+
+// ----------------------------------------------------------------------------
+// Function _appendPrintf()
+// ----------------------------------------------------------------------------
+
+inline void
+_appendPrintf(std::string & buffer, char const * format, double const v)
+{
+    char tmp[64];
+    int const n = std::snprintf(tmp, sizeof(tmp), format, v);
+    buffer.append(tmp, n);
+}
+
+// ----------------------------------------------------------------------------
+// Function _appendFixed()
+// ----------------------------------------------------------------------------
+
+// same as printf("%<width>.<prec>f", v) for prec <= 3
+inline void
+_appendFixed(std::string & buffer, double const v, unsigned const prec, unsigned const width,
+             char const * format)
+{
+    static constexpr uint64_t pow10[] = { 1, 10, 100, 1000 };
+
+    double const scaled = v * pow10[prec];
+    // the error of scaled is far below 1e-6 in this range
+    if (!(v >= 0) || !(scaled < 1e9))
+        return _appendPrintf(buffer, format, v);
+
+    double const fl = std::floor(scaled);
+    double const frac = scaled - fl;
+    if (std::abs(frac - 0.5) < 1e-6) // printf rounds the exact binary value
+        return _appendPrintf(buffer, format, v);
+
+    uint64_t const r = static_cast<uint64_t>(fl) + (frac > 0.5);
+
+    char tmp[24];
+    char * p = tmp + sizeof(tmp);
+    uint64_t i = r / pow10[prec];
+    uint64_t f = r % pow10[prec];
+    for (unsigned j = 0; j < prec; ++j)
+    {
+        *--p = '0' + (f % 10);
+        f /= 10;
+    }
+    if (prec > 0)
+        *--p = '.';
+    do
+    {
+        *--p = '0' + (i % 10);
+        i /= 10;
+    } while (i);
+
+    unsigned const len = tmp + sizeof(tmp) - p;
+    if (len < width)
+        buffer.append(width - len, ' ');
+    buffer.append(p, len);
+}
+
+// ----------------------------------------------------------------------------
+// Function _appendExp0()
+// ----------------------------------------------------------------------------
+
+// same as printf("%.0le", v) for 0 < v < 1 (no width needed, always >= 5 chars)
+inline void
+_appendExp0(std::string & buffer, double const v, char const * format)
+{
+    if (!(v > 0) || !(v < 1))
+        return _appendPrintf(buffer, format, v);
+
+    int e = static_cast<int>(std::floor(std::log10(v)));
+    double m = v * std::pow(10.0, -e);
+    if (m < 1.0)
+    {
+        --e;
+        m *= 10;
+    }
+    else if (m >= 10.0)
+    {
+        ++e;
+        m /= 10;
+    }
+
+    double const fl = std::floor(m);
+    double const frac = m - fl;
+    // m carries a relative error of a few ulp, leave close calls to printf
+    if ((std::abs(frac - 0.5) < 1e-9) || (frac < 1e-9) || (frac > 1 - 1e-9))
+        return _appendPrintf(buffer, format, v);
+
+    unsigned d = static_cast<unsigned>(fl) + (frac > 0.5);
+    if (d == 10)
+    {
+        d = 1;
+        ++e;
+    }
+
+    buffer.push_back('0' + d);
+    buffer.push_back('e');
+    buffer.push_back(e < 0 ? '-' : '+');
+    unsigned const ae = std::abs(e);
+    if (ae < 10)
+        buffer.push_back('0');
+    _appendUInt(buffer, ae);
+}
+
+// ----------------------------------------------------------------------------
+// Function _appendEValue() / _appendBitScore()
+// ----------------------------------------------------------------------------
+
+// format choice imported from NCBI code (see seqan's _writeField())
+inline void
+_appendEValue(std::string & buffer, double const eValue)
+{
+    if (eValue < 1.0e-180)
+        _appendFixed(buffer, eValue, 1, 3, "%3.1lf");
+    else if (eValue < 1.0e-99)
+        _appendExp0(buffer, eValue, "%2.0le");
+    else if (eValue < 0.0009)
+        _appendExp0(buffer, eValue, "%3.0le");
+    else if (eValue < 0.1)
+        _appendFixed(buffer, eValue, 3, 4, "%4.3lf");
+    else if (eValue < 1.0)
+        _appendFixed(buffer, eValue, 2, 3, "%3.2lf");
+    else if (eValue < 10.0)
+        _appendFixed(buffer, eValue, 1, 2, "%2.1lf");
+    else
+        _appendFixed(buffer, eValue, 0, 5, "%5.0lf");
+}
+
+inline void
+_appendBitScore(std::string & buffer, double const bitScore)
+{
+    if (bitScore > 9999)
+        _appendPrintf(buffer, "%4.3le", bitScore);
+    else if (bitScore > 99.9)
+        _appendFixed(buffer, bitScore, 0, 4, "%4.0lf");
+    else
+        _appendFixed(buffer, bitScore, 1, 4, "%4.1lf");
+}
+
+// ----------------------------------------------------------------------------
+// Function _appendId()
+// ----------------------------------------------------------------------------
+
+// NCBI truncates ids at the first space
+template <typename TId>
+inline void
+_appendId(std::string & buffer, TId const & id)
+{
+    auto const itBeg = begin(id, Standard());
+    buffer.append(itBeg, std::find(itBeg, end(id, Standard()), ' '));
+}
+
+// ----------------------------------------------------------------------------
+// Function _appendTabularMatch()
+// ----------------------------------------------------------------------------
+
+template <typename TContext, typename TBlastMatch>
+inline void
+_appendTabularMatch(std::string                                & buffer,
+                    TContext                                   & context,
+                    TBlastMatch                          const & m,
+                    std::vector<BlastMatchField<>::Enum> const & plan)
+{
+    using TPos = typename TBlastMatch::TPos;
+    using TField = BlastMatchField<>::Enum;
+
+    for (auto it = plan.begin(); it != plan.end(); ++it)
+    {
+        if (it != plan.begin())
+            buffer.push_back('\t');
+
+        switch (*it)
+        {
+            case TField::Q_SEQ_ID:
+                _appendId(buffer, m.qId);
+                break;
+            case TField::Q_LEN:
+                _appendUInt(buffer, m.qLength);
+                break;
+            case TField::S_SEQ_ID:
+                _appendId(buffer, m.sId);
+                break;
+            case TField::S_LEN:
+                _appendUInt(buffer, m.sLength);
+                break;
+            case TField::Q_START:
+            case TField::Q_END:
+            {
+                TPos start = m.qStart;
+                TPos end = m.qEnd;
+                _untranslateQPositions(start, end, m.qFrameShift, m.qLength, context.blastProgram);
+                _appendUInt(buffer, (*it == TField::Q_START) ? start : end);
+            } break;
+            case TField::S_START:
+            case TField::S_END:
+            {
+                TPos start = m.sStart;
+                TPos end = m.sEnd;
+                _untranslateSPositions(start, end, m.sFrameShift, m.sLength, context.blastProgram);
+                _appendUInt(buffer, (*it == TField::S_START) ? start : end);
+            } break;
+            case TField::E_VALUE:
+                _appendEValue(buffer, m.eValue);
+                break;
+            case TField::BIT_SCORE:
+                _appendBitScore(buffer, m.bitScore);
+                break;
+            case TField::SCORE:
+                _appendInt(buffer, m.alignStats.alignmentScore);
+                break;
+            case TField::LENGTH:
+                _appendUInt(buffer, m.alignStats.alignmentLength);
+                break;
+            case TField::P_IDENT:
+                _appendFixed(buffer, m.alignStats.alignmentIdentity, 2, 0, "%.2f");
+                break;
+            case TField::N_IDENT:
+                _appendUInt(buffer, m.alignStats.numMatches);
+                break;
+            case TField::MISMATCH:
+                _appendUInt(buffer, m.alignStats.numMismatches +
+                                    (context.legacyFormat ? m.alignStats.numGaps : 0));
+                break;
+            case TField::POSITIVE:
+                _appendUInt(buffer, m.alignStats.numPositiveScores);
+                break;
+            case TField::GAP_OPEN:
+                _appendUInt(buffer, m.alignStats.numGapOpens);
+                break;
+            case TField::GAPS:
+                _appendUInt(buffer, m.alignStats.numGaps);
+                break;
+            case TField::P_POS:
+                _appendFixed(buffer, m.alignStats.alignmentSimilarity, 2, 0, "%.2f");
+                break;
+            case TField::FRAMES:
+                // for formats that don't have frames, blast says 0 instead of +1
+                _appendInt(buffer, (qNumFrames(context.blastProgram) > 1) ? m.qFrameShift : 0);
+                buffer.push_back('/');
+                _appendInt(buffer, (sNumFrames(context.blastProgram) > 1) ? m.sFrameShift : 0);
+                break;
+            case TField::Q_FRAME:
+                _appendInt(buffer, (qNumFrames(context.blastProgram) > 1) ? m.qFrameShift : 0);
+                break;
+            case TField::S_FRAME:
+                _appendInt(buffer, (sNumFrames(context.blastProgram) > 1) ? m.sFrameShift : 0);
+                break;
+            default:
+                buffer.append("n/i"); // not implemented
+        }
+    }
+    buffer.push_back('\n');
+}
+
+// ----------------------------------------------------------------------------
+// Function writeTabularRecord()
+// ----------------------------------------------------------------------------
+
+// replaces writeRecord(buffer, context, record, BlastTabular()); plan is
+// made by makeTabularColumnPlan() from context.fields
+template <typename TContext, typename TBlastRecord>
+inline void
+writeTabularRecord(std::string                                & buffer,
+                   TContext                                   & context,
+                   TBlastRecord                         const & record,
+                   std::vector<BlastMatchField<>::Enum> const & plan)
+{
+    // no-op for .m8
+    _writeCommentLines(buffer, context, record, BlastTabular());
+
+    for (auto const & m : record.matches)
+        _appendTabularMatch(buffer, context, m, plan);
+}
+
+#endif // SEQAN_LAMBDA_TABULAR_OUTPUT_H_
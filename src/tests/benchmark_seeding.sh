@@ -0,0 +1,78 @@
+#!/bin/bash
+# ===========================================================================
+#                                  lambda
+# ===========================================================================
+# benchmark_seeding.sh: compares the seeding engines on generated data
+#
+# usage: benchmark_seeding.sh BINDIR [WORKDIR]
+#
+# BINDIR has to contain lambda and lambda_indexer. A database of 750
+# protein sequences and 3000 queries (each a window of a database sequence
+# with 20% substitutions) are generated with a fixed random seed, so every
+# run uses the same data. For every query index and seed-delta the run time,
+# seeding time and number of hits after seeding of both engines are printed,
+# and it is checked whether their output is the same.
+# ===========================================================================
+
+set -e
+
+BINDIR=$(cd "${1:?usage: $0 BINDIR [WORKDIR]}" && pwd)
+WORKDIR=${2:-$(mktemp -d)}
+cd "${WORKDIR}"
+
+awk 'BEGIN {
+    srand(4711);
+    aa = "ACDEFGHIKLMNPQRSTVWY";
+    for (s = 0; s < 750; ++s)
+    {
+        db[s] = "";
+        len = 200 + int(rand() * 300);
+        for (i = 0; i < len; ++i)
+            db[s] = db[s] substr(aa, 1 + int(rand() * 20), 1);
+        print ">s" s > "db.fa";
+        print db[s] > "db.fa";
+    }
+    for (q = 0; q < 3000; ++q)
+    {
+        s = int(rand() * 750);
+        len = 100 + int(rand() * 100);
+        start = 1 + int(rand() * (length(db[s]) - len));
+        seq = "";
+        for (i = 0; i < len; ++i)
+        {
+            c = substr(db[s], start + i, 1);
+            if (rand() < 0.2)
+                c = substr(aa, 1 + int(rand() * 20), 1);
+            seq = seq c;
+        }
+        print ">q" q > "query.fa";
+        print seq > "query.fa";
+    }
+}'
+
+"${BINDIR}/lambda_indexer" -d db.fa -di sa -p blastp > /dev/null
+
+printf "%-6s %-3s %-13s %8s %8s %8s\n" "qi" "sd" "engine" "total" "seeding" "hits"
+for QI in none radix; do
+    for SD in 1 2; do
+        for ENGINE in backtracking pigeonhole; do
+            LOG=${QI}_${SD}_${ENGINE}.log
+            START=$(date +%s%N)
+            "${BINDIR}/lambda" -q query.fa -d db.fa -di sa -p blastp -t 1 -qi ${QI} -sd ${SD} \
+                --seeding-engine ${ENGINE} -o ${QI}_${SD}_${ENGINE}.m8 -v 2 > ${LOG} 2>&1
+            END=$(date +%s%N)
+            # without query index seeding and extension are interleaved
+            SEEDING=$(grep -ao "Seeding... done. [0-9.]*s" ${LOG} | tail -1 | grep -o "[0-9.]*s$" || echo "-")
+            HITS=$(grep -a "after Seeding" ${LOG} | awk '{ print $3 }')
+            printf "%-6s %-3s %-13s %7.2fs %8s %8s\n" ${QI} ${SD} ${ENGINE} \
+                $(awk "BEGIN { print (${END} - ${START}) / 1e9 }") ${SEEDING} ${HITS}
+        done
+        if cmp -s ${QI}_${SD}_backtracking.m8 ${QI}_${SD}_pigeonhole.m8; then
+            echo "  output identical"
+        else
+            echo "  output differs"
+        fi
+    done
+done
+
+echo "results are in ${WORKDIR}"
@@ -0,0 +1,221 @@
+// ==========================================================================
+//                                  lambda
+// ==========================================================================
+// Copyright (c) 2013-2015, Hannes Hauswedell, FU Berlin
+// All rights reserved.
+//
+// This file is part of Lambda.
+//
+// Lambda is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Lambda is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with Lambda.  If not, see <http://www.gnu.org/licenses/>.*/
+// ==========================================================================
+// Author: Hannes Hauswedell <hannes.hauswedell @ fu-berlin.de>
+// ==========================================================================
+// test_pigeonhole.cpp: compares pigeonholeFind() with a scan of all windows
+// ==========================================================================
+
+#include <algorithm>
+#include <random>
+#include <utility>
+#include <vector>
+
+// lambda's definitions disable the test system in release builds
+#undef SEQAN_ENABLE_TESTING
+#define SEQAN_ENABLE_TESTING 1
+
+#include <seqan/basic.h>
+#include <seqan/sequence.h>
+#include <seqan/index.h>
+
+#include "index_sa_sort.h"
+#include "pigeonhole.hpp"
+
+using namespace seqan;
+
+typedef StringSet<String<Dna> >             TSeqs;
+typedef std::pair<uint64_t, uint64_t>       TOcc;   // (seqNo, offset of the window)
+// created as by lambda_indexer, seqan's default Skew7 is not used there
+typedef SaAdvancedSort<MergeSortTag>        TSaAlgo;
+
+// ----------------------------------------------------------------------------
+// Function referenceOccs()
+// ----------------------------------------------------------------------------
+
+// all windows with at most maxDist mismatches, sorted
+inline std::vector<TOcc>
+referenceOccs(TSeqs const & seqs, String<Dna> const & seed, unsigned const maxDist)
+{
+    std::vector<TOcc> occs;
+    for (uint64_t s = 0; s < length(seqs); ++s)
+    {
+        for (uint64_t i = 0; i + length(seed) <= length(seqs[s]); ++i)
+        {
+            unsigned mismatches = 0;
+            for (uint64_t j = 0; j < length(seed); ++j)
+                mismatches += (seed[j] != seqs[s][i + j]);
+            if (mismatches <= maxDist)
+                occs.push_back(TOcc(s, i));
+        }
+    }
+    return occs;
+}
+
+// ----------------------------------------------------------------------------
+// Function pigeonholeOccs()
+// ----------------------------------------------------------------------------
+
+// the hits of pigeonholeFind() in the order of referenceOccs(); duplicates
+// are kept, so that they show up as a difference, and the positions of a
+// reversed index are turned around like in _pigeonholeWindow()
+template <typename TIndex>
+inline std::vector<TOcc>
+pigeonholeOccs(TIndex & index, TSeqs const & seqs, String<Dna> const & seed, unsigned const maxDist,
+               bool const reversedIndex)
+{
+    String<typename SAValue<TIndex>::Type> subjOccs;
+    pigeonholeFind(subjOccs, index, seqs, seed, maxDist, reversedIndex);
+
+    std::vector<TOcc> occs;
+    for (auto const & occ : subjOccs)
+        occs.push_back(TOcc(getSeqNo(occ),
+                            reversedIndex ? length(seqs[getSeqNo(occ)]) - getSeqOffset(occ) - length(seed)
+                                          : getSeqOffset(occ)));
+    std::sort(occs.begin(), occs.end());
+    return occs;
+}
+
+// ----------------------------------------------------------------------------
+// Function randomSeqs(), randomSeed()
+// ----------------------------------------------------------------------------
+
+inline TSeqs
+randomSeqs(std::mt19937 & rng, unsigned const n, unsigned const maxLen)
+{
+    std::uniform_int_distribution<unsigned> len(1, maxLen);
+    std::uniform_int_distribution<unsigned> base(0, 3);
+    TSeqs seqs;
+    for (unsigned s = 0; s < n; ++s)
+    {
+        String<Dna> seq;
+        resize(seq, len(rng));
+        for (unsigned i = 0; i < length(seq); ++i)
+            seq[i] = Dna(base(rng));
+        appendValue(seqs, seq);
+    }
+    return seqs;
+}
+
+// a window of the sequences with up to maxDist + 1 substitutions, or a
+// random word if there is no window
+inline String<Dna>
+randomSeed(std::mt19937 & rng, TSeqs const & seqs, unsigned const len, unsigned const maxDist)
+{
+    std::uniform_int_distribution<unsigned> base(0, 3);
+    String<Dna> seed;
+    resize(seed, len);
+    for (unsigned i = 0; i < len; ++i)
+        seed[i] = Dna(base(rng));
+
+    unsigned const s = std::uniform_int_distribution<unsigned>(0, length(seqs) - 1)(rng);
+    if (length(seqs[s]) < len)
+        return seed;
+    unsigned const start = std::uniform_int_distribution<unsigned>(0, length(seqs[s]) - len)(rng);
+    seed = infix(seqs[s], start, start + len);
+    unsigned const subs = std::uniform_int_distribution<unsigned>(0, maxDist + 1)(rng);
+    for (unsigned k = 0; k < subs; ++k)
+        seed[std::uniform_int_distribution<unsigned>(0, len - 1)(rng)] = Dna(base(rng));
+    return seed;
+}
+
+// ----------------------------------------------------------------------------
+// Tests
+// ----------------------------------------------------------------------------
+
+SEQAN_DEFINE_TEST(test_pigeonhole_part)
+{
+    // the parts cover the seed without gaps or overlaps
+    for (uint64_t len = 1; len < 20; ++len)
+    {
+        for (uint64_t parts = 1; parts <= len; ++parts)
+        {
+            uint64_t prevEnd = 0;
+            for (uint64_t k = 0; k < parts; ++k)
+            {
+                uint64_t b, e;
+                _pigeonholePart(b, e, k, parts, len);
+                SEQAN_ASSERT_EQ(b, prevEnd);
+                SEQAN_ASSERT_LT(b, e);
+                prevEnd = e;
+            }
+            SEQAN_ASSERT_EQ(prevEnd, len);
+        }
+    }
+}
+
+SEQAN_DEFINE_TEST(test_pigeonhole_find)
+{
+    std::mt19937 rng(42);
+    for (unsigned round = 0; round < 20; ++round)
+    {
+        TSeqs seqs = randomSeqs(rng, 30, 200);
+        // built like lambda_indexer does and searched like lambda does
+        Index<TSeqs, IndexSa<TSaAlgo> > builtIndex(seqs);
+        indexCreate(builtIndex, seqs, FibreSA(), [] () {});
+        Index<TSeqs, IndexSa<> > index(seqs);
+        indexSA(index) = indexSA(builtIndex);
+
+        for (unsigned maxDist = 0; maxDist <= 3; ++maxDist)
+        {
+            for (unsigned k = 0; k < 50; ++k)
+            {
+                unsigned const len = std::uniform_int_distribution<unsigned>(maxDist + 1, 14)(rng);
+                String<Dna> const seed = randomSeed(rng, seqs, len, maxDist);
+                SEQAN_ASSERT(pigeonholeOccs(index, seqs, seed, maxDist, false) ==
+                             referenceOccs(seqs, seed, maxDist));
+            }
+        }
+    }
+}
+
+SEQAN_DEFINE_TEST(test_pigeonhole_find_reversed)
+{
+    // the FM index is built on the reversed sequences, see lambda_indexer.hpp
+    std::mt19937 rng(4711);
+    for (unsigned round = 0; round < 20; ++round)
+    {
+        TSeqs seqs = randomSeqs(rng, 30, 200);
+        TSeqs revSeqs = seqs;
+        reverse(revSeqs);
+        Index<TSeqs, FMIndex<TSaAlgo> > revIndex(revSeqs);
+        indexCreate(revIndex, revSeqs, FibreSALF(), [] () {});
+
+        for (unsigned maxDist = 0; maxDist <= 3; ++maxDist)
+        {
+            for (unsigned k = 0; k < 50; ++k)
+            {
+                unsigned const len = std::uniform_int_distribution<unsigned>(maxDist + 1, 14)(rng);
+                String<Dna> const seed = randomSeed(rng, seqs, len, maxDist);
+                SEQAN_ASSERT(pigeonholeOccs(revIndex, seqs, seed, maxDist, true) ==
+                             referenceOccs(seqs, seed, maxDist));
+            }
+        }
+    }
+}
+
+SEQAN_BEGIN_TESTSUITE(test_pigeonhole)
+{
+    SEQAN_CALL_TEST(test_pigeonhole_part);
+    SEQAN_CALL_TEST(test_pigeonhole_find);
+    SEQAN_CALL_TEST(test_pigeonhole_find_reversed);
+}
+SEQAN_END_TESTSUITE
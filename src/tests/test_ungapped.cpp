@@ -0,0 +1,190 @@
+// ==========================================================================
+//                                  lambda
+// ==========================================================================
+// Copyright (c) 2013-2015, Hannes Hauswedell, FU Berlin
+// All rights reserved.
+//
+// This file is part of Lambda.
+//
+// Lambda is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Lambda is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with Lambda.  If not, see <http://www.gnu.org/licenses/>.*/
+// ==========================================================================
+// Author: Hannes Hauswedell <hannes.hauswedell @ fu-berlin.de>
+// ==========================================================================
+// test_ungapped.cpp: compares the ungapped kernels with the per-cell loop
+// they replaced; built with and without SSE4.1
+// ==========================================================================
+
+#include <random>
+#include <vector>
+
+// lambda's definitions disable the test system in release builds
+#undef SEQAN_ENABLE_TESTING
+#define SEQAN_ENABLE_TESTING 1
+
+#include <seqan/basic.h>
+#include <seqan/sequence.h>
+#include <seqan/score.h>
+
+#include "ungapped.hpp"
+
+using namespace seqan;
+
+// ----------------------------------------------------------------------------
+// Function referenceAlignment()
+// ----------------------------------------------------------------------------
+
+// the diagonal scoring of computeHSP() before ungapped.hpp
+template <typename TSeq0, typename TSeq1, typename TScoreScheme>
+inline UngappedAlignment
+referenceAlignment(TSeq0 const & seq0, TSeq1 const & seq1, unsigned const len, TScoreScheme const & scheme)
+{
+    std::vector<int> scores(len + 1);
+    int scr = 0;
+    unsigned newEnd = 0;
+    unsigned newBeg = 0;
+    scores[0] = 0;
+    for (unsigned i = 0; i < len; ++i)
+    {
+        scores[i] += score(scheme, seq0[i], seq1[i]);
+        if (scores[i] < 0)
+        {
+            scores[i] = 0;
+        } else if (scores[i] >= scr)
+        {
+            scr = scores[i];
+            newEnd = i + 1;
+        }
+        scores[i+1] = scores[i];
+    }
+    if (newEnd != 0)
+    {
+        for (unsigned i = newEnd - 1; i > 0; --i)
+        {
+            if (scores[i] == 0)
+            {
+                newBeg = i + 1;
+                break;
+            }
+        }
+    }
+    return UngappedAlignment{ scr, newBeg, newEnd };
+}
+
+// ----------------------------------------------------------------------------
+// Function compareWithReference()
+// ----------------------------------------------------------------------------
+
+template <typename TSeq, typename TScoreScheme>
+inline void
+compareWithReference(TSeq const & seq0, TSeq const & seq1, TScoreScheme const & scheme)
+{
+    typedef typename Value<TSeq>::Type TAlph;
+
+    UngappedScoreTable table;
+    makeUngappedScoreTable<TAlph>(table, scheme);
+
+    unsigned const len = length(seq0);
+    std::vector<int> buffer(len + 1);
+
+    UngappedAlignment const ref = referenceAlignment(seq0, seq1, len, scheme);
+    UngappedAlignment const ali = ungappedAlignment(seq0, seq1, len, table, &buffer[0]);
+
+    SEQAN_ASSERT_EQ(ungappedScore(seq0, seq1, len, table), ref.score);
+    SEQAN_ASSERT_EQ(ali.score, ref.score);
+    SEQAN_ASSERT_EQ(ali.endPos, ref.endPos);
+    if (ref.endPos != 0)
+        SEQAN_ASSERT_EQ(ali.beginPos, ref.beginPos);
+
+    // the scalar path must agree, too, even if the SIMD path was taken above
+    auto const rows = tableRows(table, begin(seq0, Standard()));
+    SEQAN_ASSERT_EQ(_ungappedScanScalar(rows, begin(seq1, Standard()), len, nullptr, 0, 0, 0), ref.score);
+}
+
+// ----------------------------------------------------------------------------
+// Function randomSeq()
+// ----------------------------------------------------------------------------
+
+template <typename TAlph>
+inline String<TAlph>
+randomSeq(std::mt19937 & rng, unsigned const len, unsigned const alphSize)
+{
+    std::uniform_int_distribution<unsigned> dist(0, alphSize - 1);
+    String<TAlph> seq;
+    resize(seq, len);
+    for (unsigned i = 0; i < len; ++i)
+        seq[i] = TAlph(dist(rng));
+    return seq;
+}
+
+// ----------------------------------------------------------------------------
+// Tests
+// ----------------------------------------------------------------------------
+
+SEQAN_DEFINE_TEST(test_ungapped_random_protein)
+{
+    std::mt19937 rng(42);
+    Blosum62 scheme;
+    for (unsigned round = 0; round < 2000; ++round)
+    {
+        unsigned const len = round % 101;
+        String<AminoAcid> seq0 = randomSeq<AminoAcid>(rng, len, 20);
+        String<AminoAcid> seq1 = randomSeq<AminoAcid>(rng, len, 20);
+        compareWithReference(seq0, seq1, scheme);
+    }
+}
+
+SEQAN_DEFINE_TEST(test_ungapped_random_dna)
+{
+    // +1/-1 on a small alphabet produces many equal maxima and zeros
+    std::mt19937 rng(4711);
+    Score<int, Simple> scheme(1, -1, -1);
+    for (unsigned round = 0; round < 5000; ++round)
+    {
+        unsigned const len = round % 67;
+        String<Dna> seq0 = randomSeq<Dna>(rng, len, 2);
+        String<Dna> seq1 = randomSeq<Dna>(rng, len, 2);
+        compareWithReference(seq0, seq1, scheme);
+    }
+}
+
+SEQAN_DEFINE_TEST(test_ungapped_ties)
+{
+    Score<int, Simple> scheme(1, -1, -1);
+
+    // same maximum twice, the later one is reported
+    compareWithReference(String<Dna>("AACCAA"), String<Dna>("AAGGAA"), scheme);
+    // same maximum twice without a zero in between
+    compareWithReference(String<Dna>("AACAA"), String<Dna>("AAGAA"), scheme);
+    // maximum in the first cell and again later
+    compareWithReference(String<Dna>("ACA"), String<Dna>("AGA"), scheme);
+    // only mismatches: no local alignment
+    compareWithReference(String<Dna>("AAAAAAAAA"), String<Dna>("CCCCCCCCC"), scheme);
+    // score drops to exactly zero without clamping, then continues
+    compareWithReference(String<Dna>("ACAAAAC"), String<Dna>("AGAAAAG"), scheme);
+    compareWithReference(String<Dna>("ACG"), String<Dna>("AGC"), scheme);
+    // zero after a mismatch clamped at the first cell
+    compareWithReference(String<Dna>("CAAAAAAAA"), String<Dna>("GAAAAAAAA"), scheme);
+    // all matches, longer than one SIMD block
+    compareWithReference(String<Dna>("ACGTACGTACGTA"), String<Dna>("ACGTACGTACGTA"), scheme);
+    // empty
+    compareWithReference(String<Dna>(""), String<Dna>(""), scheme);
+}
+
+SEQAN_BEGIN_TESTSUITE(test_ungapped)
+{
+    SEQAN_CALL_TEST(test_ungapped_random_protein);
+    SEQAN_CALL_TEST(test_ungapped_random_dna);
+    SEQAN_CALL_TEST(test_ungapped_ties);
+}
+SEQAN_END_TESTSUITE
@@ -0,0 +1,478 @@
+// ==========================================================================
+//                                  lambda
+// ==========================================================================
+// Copyright (c) 2013-2015, Hannes Hauswedell, FU Berlin
+// All rights reserved.
+//
+// This file is part of Lambda.
+//
+// Lambda is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Lambda is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with Lambda.  If not, see <http://www.gnu.org/licenses/>.*/
+// ==========================================================================
+// Author: Hannes Hauswedell <hannes.hauswedell @ fu-berlin.de>
+// ==========================================================================
+// ungapped.hpp: scoring of a single diagonal (pre-scoring, gap-free matches)
+// ==========================================================================
+
+#ifndef SEQAN_LAMBDA_UNGAPPED_H_
+#define SEQAN_LAMBDA_UNGAPPED_H_
+
+#include <algorithm>
+#include <climits>
+#include <cstdint>
+#include <vector>
+
+#if defined(__SSE4_1__)
+#include <smmintrin.h>
+#endif
+
+#include <seqan/basic.h>
+#include <seqan/score.h>
+
+using namespace seqan;
+
+// The best local score on a diagonal is computed as
+//
+//   K[i] = P[i] - min(0, P[0], ..., P[i])      (P = prefix sums of the scores)
+//
+// which is the same as the usual max(0, K[i-1] + s[i]) recurrence, but can be
+// evaluated as a SIMD prefix-sum and prefix-minimum four cells at a time.
+// AVX2 is not used, because its shifts do not cross the 128bit lanes and the
+// scan would need as many extra permutes as it saves.
+
+// ============================================================================
+// Tags, Classes, Enums
+// ============================================================================
+
+// ----------------------------------------------------------------------------
+// struct UngappedScoreTable
+// ----------------------------------------------------------------------------
+
+// substitution scores as flat array, indexed by ordValue(q) * alphSize + ordValue(s)
+struct UngappedScoreTable
+{
+    unsigned            alphSize = 0;
+    std::vector<int>    scores;
+    int                 maxScore = 0;   // highest entry of scores
+};
+
+// ----------------------------------------------------------------------------
+// struct QueryProfile
+// ----------------------------------------------------------------------------
+
+// the rows of the UngappedScoreTable for every position of the frames of one
+// query, so that the kernels read consecutive rows instead of looking up each
+// query character; see makeQueryProfile()
+struct QueryProfile
+{
+    uint64_t                qryBegin = 0;   // first frame (as qryId)
+    uint64_t                qryEnd = 0;
+    unsigned                alphSize = 0;
+    std::vector<int>        scores;
+    std::vector<uint64_t>   frameBegins;    // first row of each frame
+};
+
+// ----------------------------------------------------------------------------
+// struct TableRows, ProfileRows
+// ----------------------------------------------------------------------------
+
+// rows(i) is the score row of the i-th character of the first sequence, i.e.
+// rows(i)[ordValue(c)] is its score against c
+
+template <typename TIt>
+struct TableRows
+{
+    int const * scores;
+    unsigned    alphSize;
+    TIt         it;
+
+    int const * operator()(long const i) const { return scores + ordValue(*(it + i)) * alphSize; }
+};
+
+// rows of consecutive query positions, backwards for reverse extensions
+struct ProfileRows
+{
+    int const * first;
+    long        step;
+
+    int const * operator()(long const i) const { return first + i * step; }
+};
+
+// ----------------------------------------------------------------------------
+// struct PackedDna
+// ----------------------------------------------------------------------------
+
+// the concatenation of a set of Dna5 sequences with 2 bits per base, 32 bases
+// per word; N is stored as A and marked in nMask (bit 2i for base i), so two
+// positions are equal iff both their bases and their mask bits are equal.
+// See packDna() and ungappedScorePacked().
+struct PackedDna
+{
+    std::vector<uint64_t>   bases;
+    std::vector<uint64_t>   nMask;
+};
+
+// ----------------------------------------------------------------------------
+// struct UngappedAlignment
+// ----------------------------------------------------------------------------
+
+struct UngappedAlignment
+{
+    int         score;
+    unsigned    beginPos;
+    unsigned    endPos;     // 0 if there is no local alignment
+};
+
+// ============================================================================
+// Functions
+// ============================================================================
+
+// ----------------------------------------------------------------------------
+// Function makeUngappedScoreTable()
+// ----------------------------------------------------------------------------
+
+template <typename TAlph, typename TScoreScheme>
+inline void
+makeUngappedScoreTable(UngappedScoreTable & table, TScoreScheme const & scheme)
+{
+    table.alphSize = ValueSize<TAlph>::VALUE;
+    table.scores.resize(table.alphSize * table.alphSize);
+    for (unsigned i = 0; i < table.alphSize; ++i)
+        for (unsigned j = 0; j < table.alphSize; ++j)
+            table.scores[i * table.alphSize + j] = score(scheme, TAlph(i), TAlph(j));
+    table.maxScore = *std::max_element(table.scores.begin(), table.scores.end());
+}
+
+// ----------------------------------------------------------------------------
+// Function tableRows()
+// ----------------------------------------------------------------------------
+
+template <typename TIt>
+inline TableRows<TIt>
+tableRows(UngappedScoreTable const & table, TIt it)
+{
+    return TableRows<TIt>{ &table.scores[0], table.alphSize, it };
+}
+
+// ----------------------------------------------------------------------------
+// Function makeQueryProfile()
+// ----------------------------------------------------------------------------
+
+// the profile of the sequences [qryBegin, qryEnd) of qrySeqs, usually the
+// frames of one query
+template <typename TSeqs>
+inline void
+makeQueryProfile(QueryProfile             & profile,
+                 TSeqs              const & qrySeqs,
+                 uint64_t           const   qryBegin,
+                 uint64_t           const   qryEnd,
+                 UngappedScoreTable const & table)
+{
+    profile.qryBegin = qryBegin;
+    profile.qryEnd = qryEnd;
+    profile.alphSize = table.alphSize;
+
+    profile.frameBegins.resize(qryEnd - qryBegin + 1);
+    profile.frameBegins[0] = 0;
+    for (uint64_t q = qryBegin; q < qryEnd; ++q)
+        profile.frameBegins[q - qryBegin + 1] = profile.frameBegins[q - qryBegin] + length(qrySeqs[q]);
+
+    profile.scores.resize(profile.frameBegins.back() * table.alphSize);
+    int * out = profile.scores.empty() ? nullptr : &profile.scores[0];
+    for (uint64_t q = qryBegin; q < qryEnd; ++q)
+    {
+        for (auto const & c : qrySeqs[q])
+        {
+            std::copy_n(&table.scores[ordValue(c) * table.alphSize], table.alphSize, out);
+            out += table.alphSize;
+        }
+    }
+}
+
+// ----------------------------------------------------------------------------
+// Function profileRows()
+// ----------------------------------------------------------------------------
+
+// rows of sequence qryId starting at pos, for reverse the rows of pos - 1,
+// pos - 2, ...
+inline ProfileRows
+profileRows(QueryProfile const & profile, uint64_t const qryId, uint64_t const pos, bool const reverse = false)
+{
+    SEQAN_ASSERT(qryId >= profile.qryBegin && qryId < profile.qryEnd);
+    uint64_t const row = profile.frameBegins[qryId - profile.qryBegin] + pos - reverse;
+    return ProfileRows{ &profile.scores[0] + row * profile.alphSize,
+                        reverse ? -long(profile.alphSize) : long(profile.alphSize) };
+}
+
+// ----------------------------------------------------------------------------
+// Function simpleScores()
+// ----------------------------------------------------------------------------
+
+// whether the table only distinguishes matches from mismatches (as for
+// Score<int, Simple>); if so, the two scores are returned in match and mismatch
+inline bool
+simpleScores(int & match, int & mismatch, UngappedScoreTable const & table)
+{
+    if (table.alphSize < 2)
+        return false;
+    match = table.scores[0];
+    mismatch = table.scores[1];
+    for (unsigned i = 0; i < table.alphSize; ++i)
+        for (unsigned j = 0; j < table.alphSize; ++j)
+            if (table.scores[i * table.alphSize + j] != ((i == j) ? match : mismatch))
+                return false;
+    return true;
+}
+
+// ----------------------------------------------------------------------------
+// Function packDna()
+// ----------------------------------------------------------------------------
+
+// packs a Dna5 string (usually the concat of a StringSet); one word of padding
+// is added so that _packedWord() may always read the following word
+template <typename TString>
+inline void
+packDna(PackedDna & packed, TString const & str)
+{
+    uint64_t const words = length(str) / 32 + 2;
+    packed.bases.assign(words, 0);
+    packed.nMask.assign(words, 0);
+
+    uint64_t i = 0;
+    for (auto it = begin(str, Standard()), itEnd = end(str, Standard()); it != itEnd; ++it, ++i)
+    {
+        unsigned const ord = ordValue(*it);
+        uint64_t const shift = 2 * (i % 32);
+        if (ord > 3) // N
+            packed.nMask[i / 32] |= uint64_t(1) << shift;
+        else
+            packed.bases[i / 32] |= uint64_t(ord) << shift;
+    }
+}
+
+// ----------------------------------------------------------------------------
+// Function ungappedScorePacked()
+// ----------------------------------------------------------------------------
+
+// the 32 positions starting at pos
+inline uint64_t
+_packedWord(std::vector<uint64_t> const & words, uint64_t const pos)
+{
+    uint64_t const w = pos / 32;
+    unsigned const shift = 2 * (pos % 32);
+    return shift ? ((words[w] >> shift) | (words[w + 1] << (64 - shift))) : words[w];
+}
+
+// bit 2i is set if position qPos + i and sPos + i differ
+inline uint64_t
+_packedMismatches(PackedDna const & qry, uint64_t const qPos, PackedDna const & subj, uint64_t const sPos)
+{
+    uint64_t const x = _packedWord(qry.bases, qPos) ^ _packedWord(subj.bases, sPos);
+    return ((x | (x >> 1)) & 0x5555555555555555ull) |
+           (_packedWord(qry.nMask, qPos) ^ _packedWord(subj.nMask, sPos));
+}
+
+// same as ungappedScore() for a table with only match and mismatch scores (see
+// simpleScores()), qPos and sPos are positions in the concatenations. The
+// diagonal is split into runs of matches at the mismatches of each word, so
+// the recurrence is evaluated once per run instead of once per base.
+inline int
+ungappedScorePacked(PackedDna const & qry, uint64_t const qPos,
+                    PackedDna const & subj, uint64_t const sPos,
+                    unsigned const len, int const match, int const mismatch)
+{
+    int k = 0;
+    int maxK = 0;
+    for (unsigned i = 0; i < len; i += 32)
+    {
+        unsigned const n = std::min(32u, len - i);
+        uint64_t mm = _packedMismatches(qry, qPos + i, subj, sPos + i);
+        if (n < 32)
+            mm &= (uint64_t(1) << (2 * n)) - 1;
+
+        // a run of r matches is max(0, k + r * match), the maximum is at one of its ends
+        unsigned j = 0;
+        for (;;)
+        {
+            unsigned const next = mm ? (__builtin_ctzll(mm) / 2) : n;
+            k = std::max(0, k + int(next - j) * match);
+            maxK = std::max(maxK, k);
+            if (next == n)
+                break;
+            k = std::max(0, k + mismatch);
+            maxK = std::max(maxK, k);
+            mm &= mm - 1;
+            j = next + 1;
+        }
+    }
+    return maxK;
+}
+
+// ----------------------------------------------------------------------------
+// Function _ungappedScan()
+// ----------------------------------------------------------------------------
+
+// computes K[0..len) as described above, stores it to kOut if that is given
+// and returns max(K), or 0 for len == 0
+
+template <typename TRows, typename TIt1>
+inline int
+_ungappedScanScalar(TRows const & rows, TIt1 it1, unsigned const len, int * kOut, int sum, int minSum, int maxK)
+{
+    for (unsigned i = 0; i < len; ++i, ++it1)
+    {
+        sum += rows(i)[ordValue(*it1)];
+        minSum = std::min(minSum, sum);
+        int const k = sum - minSum;
+        maxK = std::max(maxK, k);
+        if (kOut)
+            kOut[i] = k;
+    }
+    return maxK;
+}
+
+template <typename TRows, typename TIt1>
+inline int
+_ungappedScan(TRows const & rows, TIt1 it1, unsigned const len, int * kOut)
+{
+#if defined(__SSE4_1__)
+    __m128i const inf   = _mm_set1_epi32(INT_MAX);
+    __m128i       sum   = _mm_setzero_si128();  // P of the last cell, broadcast
+    __m128i       minS  = _mm_setzero_si128();  // min(0, P[0..]), broadcast
+    __m128i       maxK  = _mm_setzero_si128();
+
+    unsigned i = 0;
+    for (; i + 4 <= len; i += 4)
+    {
+        int const s0 = rows(i)[ordValue(*it1)];     ++it1;
+        int const s1 = rows(i + 1)[ordValue(*it1)]; ++it1;
+        int const s2 = rows(i + 2)[ordValue(*it1)]; ++it1;
+        int const s3 = rows(i + 3)[ordValue(*it1)]; ++it1;
+
+        // prefix sum
+        __m128i p = _mm_set_epi32(s3, s2, s1, s0);
+        p = _mm_add_epi32(p, _mm_slli_si128(p, 4));
+        p = _mm_add_epi32(p, _mm_slli_si128(p, 8));
+        p = _mm_add_epi32(p, sum);
+
+        // prefix minimum, shifting in +inf
+        __m128i m = _mm_min_epi32(p, _mm_alignr_epi8(p, inf, 12));
+        m = _mm_min_epi32(m, _mm_alignr_epi8(m, inf, 8));
+        m = _mm_min_epi32(m, minS);
+
+        __m128i const k = _mm_sub_epi32(p, m);
+        maxK = _mm_max_epi32(maxK, k);
+        if (kOut)
+            _mm_storeu_si128(reinterpret_cast<__m128i *>(kOut + i), k);
+
+        sum  = _mm_shuffle_epi32(p, 0xFF);
+        minS = _mm_shuffle_epi32(m, 0xFF);
+    }
+
+    maxK = _mm_max_epi32(maxK, _mm_shuffle_epi32(maxK, 0x4E));
+    maxK = _mm_max_epi32(maxK, _mm_shuffle_epi32(maxK, 0xB1));
+
+    auto const restRows = [&rows, i] (long const j) { return rows(i + j); };
+    return _ungappedScanScalar(restRows, it1, len - i, kOut ? kOut + i : kOut,
+                               _mm_cvtsi128_si32(sum), _mm_cvtsi128_si32(minS), _mm_cvtsi128_si32(maxK));
+#else
+    return _ungappedScanScalar(rows, it1, len, kOut, 0, 0, 0);
+#endif
+}
+
+// ----------------------------------------------------------------------------
+// Function ungappedScore()
+// ----------------------------------------------------------------------------
+
+// best local score on the diagonal of the rows (see TableRows) and a sequence
+// of length >= len
+template <typename TRows, typename TSeq1>
+inline int
+ungappedScore(TRows const & rows, TSeq1 const & seq1, unsigned const len)
+{
+    return _ungappedScan(rows, begin(seq1, Standard()), len, nullptr);
+}
+
+// best local score on the diagonal of two sequences of length >= len
+template <typename TSeq0, typename TSeq1>
+inline int
+ungappedScore(TSeq0 const & seq0, TSeq1 const & seq1, unsigned const len, UngappedScoreTable const & table)
+{
+    return ungappedScore(tableRows(table, begin(seq0, Standard())), seq1, len);
+}
+
+// ----------------------------------------------------------------------------
+// Function ungappedAlignment()
+// ----------------------------------------------------------------------------
+
+// best local alignment on the diagonal; ties are resolved as before: the last
+// end position with the maximum score and the begin after the last preceding
+// zero (K[0] is never treated as zero). buffer must hold len ints.
+template <typename TRows, typename TSeq1>
+inline UngappedAlignment
+ungappedAlignment(TRows const & rows, TSeq1 const & seq1, unsigned const len, int * buffer)
+{
+    UngappedAlignment ret { 0, 0, 0 };
+    ret.score = _ungappedScan(rows, begin(seq1, Standard()), len, buffer);
+
+    if (ret.score == 0)
+    {
+        // whether a cell reached 0 with or without clamping is not visible in K,
+        // but decides the end position here -- rerun the original recurrence
+        auto it1 = begin(seq1, Standard());
+        int k = 0;
+        for (unsigned i = 0; i < len; ++i, ++it1)
+        {
+            k += rows(i)[ordValue(*it1)];
+            if (k < 0)
+                k = 0;
+            else
+                ret.endPos = i + 1;
+            buffer[i] = k;
+        }
+    }
+    else
+    {
+        for (unsigned i = len; i > 0; --i)
+        {
+            if (buffer[i - 1] == ret.score)
+            {
+                ret.endPos = i;
+                break;
+            }
+        }
+    }
+
+    if (ret.endPos == 0)
+        return ret;
+
+    for (unsigned i = ret.endPos - 1; i > 0; --i)
+    {
+        if (buffer[i] == 0)
+        {
+            ret.beginPos = i + 1;
+            break;
+        }
+    }
+    return ret;
+}
+
+template <typename TSeq0, typename TSeq1>
+inline UngappedAlignment
+ungappedAlignment(TSeq0 const & seq0, TSeq1 const & seq1, unsigned const len, UngappedScoreTable const & table,
+                  int * buffer)
+{
+    return ungappedAlignment(tableRows(table, begin(seq0, Standard())), seq1, len, buffer);
+}
+
+#endif // SEQAN_LAMBDA_UNGAPPED_H_